@@ -0,0 +1,65 @@
+#include "AnalyzerTap.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ultradyn
+{
+//==============================================================================
+void AnalyzerTap::setEnabled (bool shouldBeEnabled)
+{
+    if (shouldBeEnabled && storage == nullptr)
+        storage.reset (new float[(size_t) numLanes * capacity]());
+
+    // The read index is the reader's own; the writer only ever sees more room
+    read.store (written.load (std::memory_order_acquire), std::memory_order_release);
+    enabled.store (shouldBeEnabled, std::memory_order_release);
+}
+
+void AnalyzerTap::push (const float* detector, const float* const* outputs, int numOutputs,
+                        int startSample, int numSamples) noexcept
+{
+    if (! isEnabled() || numOutputs <= 0 || numSamples <= 0)
+        return;
+
+    const uint32_t w = written.load (std::memory_order_relaxed);
+    const uint32_t used = w - read.load (std::memory_order_acquire);
+    if ((uint32_t) numSamples > (uint32_t) capacity - used)
+        return;
+
+    const float* lanes[numLanes] = { detector, outputs[0] + startSample,
+                                     outputs[std::min (1, numOutputs - 1)] + startSample };
+
+    // At most two runs per lane, either side of the wrap
+    const int start = (int) (w & (capacity - 1));
+    const int first = std::min (numSamples, capacity - start);
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        float* dest = storage.get() + (size_t) lane * capacity;
+        std::memcpy (dest + start, lanes[lane], (size_t) first * sizeof (float));
+        std::memcpy (dest, lanes[lane] + first, (size_t) (numSamples - first) * sizeof (float));
+    }
+
+    written.store (w + (uint32_t) numSamples, std::memory_order_release);
+}
+
+int AnalyzerTap::pull (float* detector, float* output, int maxSamples) noexcept
+{
+    if (! isEnabled() || maxSamples <= 0)
+        return 0;
+
+    const uint32_t r = read.load (std::memory_order_relaxed);
+    const int n = (int) std::min ((uint32_t) maxSamples, written.load (std::memory_order_acquire) - r);
+
+    const float* lanes = storage.get();
+    for (int i = 0; i < n; ++i)
+    {
+        const size_t index = (size_t) ((r + (uint32_t) i) & (capacity - 1));
+        detector[i] = lanes[index];
+        output[i] = 0.5f * (lanes[capacity + index] + lanes[2 * capacity + index]);
+    }
+
+    read.store (r + (uint32_t) n, std::memory_order_release);
+    return n;
+}
+}
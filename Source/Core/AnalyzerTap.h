@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace ultradyn
+{
+//==============================================================================
+// Signals for a spectrum analyzer, handed from the audio thread to one reader
+// thread: the first stage's detector signal (after the sidechain EQ) and the
+// first two output channels. A single-producer single-consumer ring of three
+// lanes sharing one pair of indices; the audio thread only copies into it and
+// drops a sub-block whole when the reader has fallen behind.
+//
+// Nothing is allocated or copied until a reader enables the tap; the storage
+// then stays for the life of the tap, so enabling and disabling again (an
+// editor opening and closing) neither allocates nor races the writer.
+class AnalyzerTap
+{
+public:
+    // Samples per lane; a reader polling at 30 Hz keeps well within it up to 192 kHz
+    static constexpr int capacity = 1 << 14;
+
+    // Reader thread. Enabling allocates the first time and drops whatever was
+    // left in the ring, so reading starts at the present.
+    void setEnabled (bool shouldBeEnabled);
+    bool isEnabled() const noexcept { return enabled.load (std::memory_order_acquire); }
+
+    // Audio thread: numSamples of the detector signal and of the output
+    // channels from startSample on (a mono output fills both output lanes)
+    void push (const float* detector, const float* const* outputs, int numOutputs,
+               int startSample, int numSamples) noexcept;
+
+    // Reader thread: up to maxSamples of the detector signal and of the mono
+    // sum of the output, oldest first; returns how many were read
+    int pull (float* detector, float* output, int maxSamples) noexcept;
+
+    size_t getMemoryFootprintBytes() const noexcept { return storage != nullptr ? (size_t) numLanes * capacity * sizeof (float) : 0; }
+
+private:
+    static constexpr int numLanes = 3;
+
+    std::unique_ptr<float[]> storage; // numLanes * capacity
+    std::atomic<bool> enabled { false };
+
+    // Free-running sample counts, written by one side each
+    std::atomic<uint32_t> written { 0 }, read { 0 };
+};
+}
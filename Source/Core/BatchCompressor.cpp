@@ -0,0 +1,223 @@
+#include "BatchCompressor.h"
+#include "CompressorCore.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace ultradyn
+{
+//==============================================================================
+namespace
+{
+    inline float decibelsToGain (float dB) noexcept
+    {
+        return dB > -100.0f ? std::pow (10.0f, dB * 0.05f) : 0.0f;
+    }
+
+    // Storage with room to start the data on a 64-byte boundary
+    float* alignedStorage (std::vector<float>& storage, size_t numFloats)
+    {
+        storage.assign (numFloats + 16, 0.0f);
+        const auto addr = reinterpret_cast<uintptr_t> (storage.data());
+        return storage.data() + ((64 - (addr & 63)) & 63) / sizeof (float);
+    }
+}
+
+//==============================================================================
+BatchCompressor::BatchCompressor()
+{
+    prepare (sampleRate, 1);
+}
+
+void BatchCompressor::prepare (double newSampleRate, int newNumStreams)
+{
+    sampleRate = std::max (1.0, newSampleRate);
+    numStreams = std::max (1, newNumStreams);
+    numLanes = (numStreams + batch::maxWidth - 1) / batch::maxWidth * batch::maxWidth;
+
+    tables = SharedTables::get (sampleRate);
+    dsp = &kernels::select();
+
+    // Streams beyond the old count start from the defaults; existing ones keep their settings
+    const size_t oldLanes = params.size() / ULTRADYN_NUM_PARAMS;
+    params.resize ((size_t) numLanes * ULTRADYN_NUM_PARAMS);
+    for (size_t lane = oldLanes; lane < (size_t) numLanes; ++lane)
+        for (int i = 0; i < ULTRADYN_NUM_PARAMS; ++i)
+            params[lane * ULTRADYN_NUM_PARAMS + (size_t) i] = CompressorCore::getParameterInfo (i)->defaultValue;
+
+    rows = alignedStorage (rowStorage, (size_t) batch::numRows * (size_t) numLanes);
+    frames = alignedStorage (frameStorage, (size_t) maxSubBlockSize * (size_t) numLanes);
+
+    for (int lane = 0; lane < numLanes; ++lane)
+        updateSettings (lane);
+
+    reset();
+}
+
+void BatchCompressor::reset() noexcept
+{
+    std::fill (row (batch::env), row (batch::env) + numLanes, 1.0e-12f);
+    std::fill (row (batch::gain), row (batch::gain) + numLanes, 1.0f);
+    std::fill (row (batch::upEnv), row (batch::upEnv) + numLanes, 1.0e-12f);
+    std::fill (row (batch::upGain), row (batch::upGain) + numLanes, 1.0f);
+    std::fill (row (batch::eqState), row (batch::numRows), 0.0f);
+}
+
+void BatchCompressor::setParameter (int stream, int index, float value) noexcept
+{
+    const auto* info = CompressorCore::getParameterInfo (index);
+    if (info == nullptr || value != value || stream < -1 || stream >= numStreams)
+        return;
+
+    value = std::min (std::max (value, info->minValue), info->maxValue);
+
+    const int first = stream < 0 ? 0 : stream;
+    const int last  = stream < 0 ? numStreams : stream + 1;
+
+    for (int s = first; s < last; ++s)
+    {
+        params[(size_t) s * ULTRADYN_NUM_PARAMS + (size_t) index] = value;
+        updateSettings (s);
+    }
+}
+
+float BatchCompressor::getParameter (int stream, int index) const noexcept
+{
+    if (stream < 0 || stream >= numStreams || index < 0 || index >= ULTRADYN_NUM_PARAMS)
+        return 0.0f;
+
+    return params[(size_t) stream * ULTRADYN_NUM_PARAMS + (size_t) index];
+}
+
+float BatchCompressor::getGainReductionDb (int stream) const noexcept
+{
+    return stream >= 0 && stream < numStreams ? std::max (0.0f, -DSPTables::gainToDecibels (row (batch::gain)[stream])) : 0.0f;
+}
+
+float BatchCompressor::getUpwardsGainDb (int stream) const noexcept
+{
+    return stream >= 0 && stream < numStreams ? std::max (0.0f, DSPTables::gainToDecibels (row (batch::upGain)[stream])) : 0.0f;
+}
+
+size_t BatchCompressor::getMemoryFootprintBytes() const noexcept
+{
+    size_t bytes = sizeof (*this);
+    bytes += (params.capacity() + rowStorage.capacity() + frameStorage.capacity()) * sizeof (float);
+
+    if (tables != nullptr)
+        bytes += tables->getSizeInBytes() / (size_t) std::max (1L, (long) tables.use_count());
+
+    return bytes;
+}
+
+//==============================================================================
+// The same derivations CompressorCore makes per block, once per change
+void BatchCompressor::updateSettings (int lane) noexcept
+{
+    const float* p = params.data() + (size_t) lane * ULTRADYN_NUM_PARAMS;
+    const auto set = [this, lane] (int r, float v) { row (r)[lane] = v; };
+
+    set (batch::inputGain,  decibelsToGain (p[ULTRADYN_PARAM_INPUT_GAIN]));
+    set (batch::outputGain, decibelsToGain (p[ULTRADYN_PARAM_OUTPUT_GAIN]));
+    set (batch::globalMix,  p[ULTRADYN_PARAM_GLOBAL_MIX] * 0.01f);
+
+    // A bypassed stage passes its input through unchanged
+    const bool downwardsBypass = p[ULTRADYN_PARAM_DOWNWARDS_BYPASS] > 0.5f;
+    set (batch::threshold, p[ULTRADYN_PARAM_THRESHOLD]);
+    set (batch::slope,     1.0f - 1.0f / std::max (1.0f, p[ULTRADYN_PARAM_RATIO]));
+    set (batch::knee,      p[ULTRADYN_PARAM_KNEE]);
+    set (batch::attack,    tables->timeConstantToCoeff (p[ULTRADYN_PARAM_ATTACK]));
+    set (batch::release,   tables->timeConstantToCoeff (p[ULTRADYN_PARAM_RELEASE]));
+    set (batch::mix,       downwardsBypass ? 0.0f : p[ULTRADYN_PARAM_MIX] * 0.01f);
+    set (batch::stageGain, downwardsBypass ? 1.0f : decibelsToGain (p[ULTRADYN_PARAM_DOWNWARDS_OUTPUT]));
+
+    const bool upwardsBypass = p[ULTRADYN_PARAM_UPWARDS_BYPASS] > 0.5f;
+    set (batch::upThreshold, p[ULTRADYN_PARAM_UPWARDS_THRESHOLD]);
+    set (batch::upSlope,     1.0f - 1.0f / std::max (1.0f, p[ULTRADYN_PARAM_UPWARDS_RATIO]));
+    set (batch::upKnee,      p[ULTRADYN_PARAM_UPWARDS_KNEE]);
+    set (batch::upAttack,    tables->timeConstantToCoeff (p[ULTRADYN_PARAM_UPWARDS_ATTACK]));
+    set (batch::upRelease,   tables->timeConstantToCoeff (p[ULTRADYN_PARAM_UPWARDS_RELEASE]));
+    set (batch::upMix,       upwardsBypass ? 0.0f : p[ULTRADYN_PARAM_UPWARDS_MIX] * 0.01f);
+    set (batch::upStageGain, upwardsBypass ? 1.0f : decibelsToGain (p[ULTRADYN_PARAM_UPWARDS_OUTPUT]));
+
+    // Sidechain EQ, as CompressorCore::updateSidechainEQ
+    const bool vocalMode = p[ULTRADYN_PARAM_VOCAL_MODE] > 0.5f;
+    const bool drumbusMode = p[ULTRADYN_PARAM_DRUMBUS_MODE] > 0.5f && ! vocalMode;
+
+    float modeDb = 0.0f;
+    if (vocalMode || drumbusMode)
+    {
+        const float tNorm = std::min (1.0f, std::max (0.0f, -p[ULTRADYN_PARAM_THRESHOLD] / 60.0f));
+        modeDb = tNorm * (vocalMode ? 5.0f : -5.0f);
+    }
+
+    const float hpfFreq = p[ULTRADYN_PARAM_SC_HPF_FREQ];
+    const BiquadCoeffs stages[batch::numEqStages] =
+    {
+        hpfFreq > 20.5f ? BiquadCoeffs::highPass (sampleRate, hpfFreq, 0.7071f) : BiquadCoeffs::identity(),
+        BiquadCoeffs::lowShelf (sampleRate, p[ULTRADYN_PARAM_SC_LOW_SHELF_FREQ], p[ULTRADYN_PARAM_SC_LOW_SHELF_GAIN]),
+        BiquadCoeffs::peak (sampleRate, p[ULTRADYN_PARAM_SC_PEAK_FREQ], p[ULTRADYN_PARAM_SC_PEAK_Q],
+                            p[ULTRADYN_PARAM_SC_PEAK_GAIN] + modeDb),
+        BiquadCoeffs::highShelf (sampleRate, p[ULTRADYN_PARAM_SC_HIGH_SHELF_FREQ], p[ULTRADYN_PARAM_SC_HIGH_SHELF_GAIN])
+    };
+
+    for (int s = 0; s < batch::numEqStages; ++s)
+    {
+        const int r = batch::eqCoeffs + 5 * s;
+        set (r,     stages[s].b0);
+        set (r + 1, stages[s].b1);
+        set (r + 2, stages[s].b2);
+        set (r + 3, stages[s].a1);
+        set (r + 4, stages[s].a2);
+    }
+}
+
+//==============================================================================
+void BatchCompressor::process (float* const* streams, int numSamples) noexcept
+{
+    kernels::ScopedFlushDenormals noDenormals;
+
+    for (int start = 0; start < numSamples; start += maxSubBlockSize)
+    {
+        const int n = std::min (maxSubBlockSize, numSamples - start);
+
+        // Planar streams to one frame of all lanes per sample, and back, in
+        // tiles of tileStreams streams by n samples. A tile's part of each
+        // frame row is one cache line, so the tile stays in L1 however far
+        // apart the rows are (a power-of-two lane count puts every row of a
+        // column in the same cache set). Padding lanes stay silent.
+        for (int first = 0; first < numStreams; first += tileStreams)
+        {
+            const float* src[tileStreams];
+            const int count = std::min (tileStreams, numStreams - first);
+            for (int s = 0; s < count; ++s)
+                src[s] = streams[first + s] + start;
+
+            for (int i = 0; i < n; ++i)
+            {
+                float* frame = frames + (size_t) i * (size_t) numLanes + first;
+                for (int s = 0; s < count; ++s)
+                    frame[s] = src[s][i];
+            }
+        }
+
+        dsp->compressBatch (rows, numLanes, frames, n);
+
+        for (int first = 0; first < numStreams; first += tileStreams)
+        {
+            float* dst[tileStreams];
+            const int count = std::min (tileStreams, numStreams - first);
+            for (int s = 0; s < count; ++s)
+                dst[s] = streams[first + s] + start;
+
+            for (int i = 0; i < n; ++i)
+            {
+                const float* frame = frames + (size_t) i * (size_t) numLanes + first;
+                for (int s = 0; s < count; ++s)
+                    dst[s][i] = frame[s];
+            }
+        }
+    }
+}
+}
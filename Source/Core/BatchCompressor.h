@@ -0,0 +1,78 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "BatchKernel.h"
+#include "DSPKernels.h"
+#include "SharedTables.h"
+#include "UltraDynCore.h"
+
+namespace ultradyn
+{
+//==============================================================================
+// Many independent mono streams through one compressor, one stream per SIMD
+// lane (16 per instruction with AVX-512, 8 with AVX2, 4 with SSE2/NEON). Each
+// stream has its own parameters and state; all share the sample rate.
+//
+// Meant for servers running the same chain over many channels. Compared with
+// CompressorCore it always runs downwards then upwards at audio rate, and
+// skips the upwards activity gate, startup delay, coefficient ramps and the
+// true-peak limiter and detector link: parameter changes take effect on the
+// next process() call.
+//
+// Not thread-safe: call setParameter from the thread that calls process().
+class BatchCompressor
+{
+public:
+    BatchCompressor();
+
+    void prepare (double sampleRate, int numStreams);
+    void reset() noexcept;
+
+    int getNumStreams() const noexcept { return numStreams; }
+
+    // stream -1 sets every stream; values are clamped like CompressorCore's
+    void setParameter (int stream, int index, float value) noexcept;
+    float getParameter (int stream, int index) const noexcept;
+
+    // One buffer of numSamples per stream, processed in place
+    void process (float* const* streams, int numSamples) noexcept;
+
+    // Current gain change of a stream, positive dB
+    float getGainReductionDb (int stream) const noexcept;
+    float getUpwardsGainDb (int stream) const noexcept;
+
+    // Streams advanced by one instruction at the selected kernel level
+    int getLaneWidth() const noexcept { return dsp->batchWidth; }
+
+    size_t getMemoryFootprintBytes() const noexcept;
+
+    // Samples per stream transposed at a time: short enough that the lane-major
+    // scratch stays in L2 with a thousand streams
+    static constexpr int maxSubBlockSize = 32;
+
+    // Streams per transpose tile: a cache line of lanes in each frame row
+    static constexpr int tileStreams = 16;
+
+private:
+    double sampleRate = 44100.0;
+    int numStreams = 0;
+    int numLanes = 0; // numStreams rounded up to batch::maxWidth
+
+    std::shared_ptr<const DSPTables> tables;
+    const kernels::Table* dsp = kernels::getScalarTable();
+
+    std::vector<float> params;                 // ULTRADYN_NUM_PARAMS per lane; padding lanes keep defaults
+    std::vector<float> rowStorage, frameStorage;
+    float* rows = nullptr;                     // batch::numRows x numLanes, 64-byte aligned
+    float* frames = nullptr;                   // maxSubBlockSize x numLanes, lane-major
+
+    inline float* row (int r) const noexcept   { return rows + (size_t) r * (size_t) numLanes; }
+
+    void updateSettings (int lane) noexcept;
+
+    BatchCompressor (const BatchCompressor&) = delete;
+    BatchCompressor& operator= (const BatchCompressor&) = delete;
+};
+}
@@ -0,0 +1,243 @@
+#pragma once
+
+// Multi-stream compressor kernel, written once against a small vector
+// interface and instantiated by every instruction-set level. Include it inside
+// each level's target region (DSPKernels_*.cpp) so the instantiation is built
+// for that level; DSPKernels.h has already pulled in the headers below.
+
+#include <cstdint>
+#include <cstring>
+
+namespace ultradyn
+{
+namespace batch
+{
+//==============================================================================
+// Structure-of-arrays layout: one row of numLanes floats per quantity, one lane
+// per stream, numLanes a multiple of maxWidth. Settings rows are derived from
+// the stream's parameters by BatchCompressor; state rows carry over between calls.
+static constexpr int maxWidth = 16;
+static constexpr int numEqStages = 4;
+static constexpr int numEqPasses = 2; // input for the downwards detector, wet for the upwards one
+
+enum Row
+{
+    // Settings
+    inputGain = 0, outputGain, globalMix,
+    threshold, slope, knee, attack, release, mix, stageGain,                // downwards (slope = 1 - 1/ratio)
+    upThreshold, upSlope, upKnee, upAttack, upRelease, upMix, upStageGain,  // upwards
+    eqCoeffs,                                                               // b0 b1 b2 a1 a2 per EQ stage
+    // State
+    env = eqCoeffs + 5 * numEqStages, gain, upEnv, upGain,
+    eqState,                                                                // z1 z2 per stage and pass
+    numRows = eqState + 2 * numEqStages * numEqPasses
+};
+
+//==============================================================================
+// V provides: Reg, Mask, width, load/store (aligned), loadu/storeu, set, add, sub, mul,
+// madd (a * b + c), div1 (1 / a), min, max, lt, gt, select (m ? a : b), floor, and for
+// positive normal x: exponent (unbiased, as float), mantissa (in [1, 2)),
+// pow2 (2^n for integral n).
+template <typename V>
+struct Math
+{
+    using Reg = typename V::Reg;
+
+    // log2 via the polynomial DSPTables::gainToDecibels uses
+    static inline Reg log2 (Reg x) noexcept
+    {
+        const Reg m = V::mantissa (x);
+        Reg p = V::madd (V::set (-0.07915382f), m, V::set (0.6288414f));
+        p = V::madd (p, m, V::set (-2.081128f));
+        p = V::madd (p, m, V::set (4.02845f));
+        p = V::madd (p, m, V::set (-2.496806f));
+        return V::add (V::exponent (x), p);
+    }
+
+    // 2^y for |y| < 120; relative error < 2e-5 (0.0002 dB)
+    static inline Reg exp2 (Reg y) noexcept
+    {
+        const Reg n = V::floor (y);
+        const Reg f = V::sub (y, n);
+        Reg p = V::madd (V::set (1.540353e-4f), f, V::set (1.333356e-3f));
+        p = V::madd (p, f, V::set (9.618129e-3f));
+        p = V::madd (p, f, V::set (5.550411e-2f));
+        p = V::madd (p, f, V::set (0.2402265f));
+        p = V::madd (p, f, V::set (0.6931472f));
+        p = V::madd (p, f, V::set (1.0f));
+        return V::mul (p, V::pow2 (n));
+    }
+
+    // RMS level in dB of a mean square, -100 dB floor as in the core (the
+    // floor on the level; a mean square of 1e-10 is -100 dB)
+    static inline Reg meanSquareToDb (Reg ms) noexcept
+    {
+        const Reg db = V::mul (V::set (3.0103f), log2 (V::max (ms, V::set (1.0e-10f))));
+        return V::max (db, V::set (-100.0f));
+    }
+
+    // Linear gain for dB, clamped to the range of the core's dB table
+    static inline Reg dbToGain (Reg db) noexcept
+    {
+        db = V::min (V::max (db, V::set (-120.0f)), V::set (48.0f));
+        return exp2 (V::mul (db, V::set (0.16609640f))); // log2 (10) / 20
+    }
+
+    // Soft-knee static curve: dB of gain change for a distance past threshold
+    static inline Reg curve (Reg over, Reg slope, Reg halfKnee, Reg invKnee) noexcept
+    {
+        const Reg x = V::mul (V::add (over, halfKnee), invKnee);
+        const Reg soft = V::mul (V::mul (x, x), V::sub (V::set (3.0f), V::add (x, x)));
+        const Reg full = V::mul (over, slope);
+        const Reg inKnee = V::select (V::gt (over, V::sub (V::set (0.0f), halfKnee)), V::mul (soft, full), V::set (0.0f));
+        return V::select (V::lt (over, halfKnee), inKnee, full);
+    }
+};
+
+template <typename V>
+void compress (float* rows, int numLanes, float* frames, int numSamples) noexcept
+{
+    using Reg = typename V::Reg;
+    using M = Math<V>;
+
+    for (int lane = 0; lane < numLanes; lane += V::width)
+    {
+        const auto row = [rows, numLanes, lane] (int r) { return rows + r * numLanes + lane; };
+
+        const Reg inGain = V::load (row (inputGain)), outGain = V::load (row (outputGain)), gMix = V::load (row (globalMix));
+        const Reg thr = V::load (row (threshold)), slp = V::load (row (slope));
+        const Reg att = V::load (row (attack)), rel = V::load (row (release));
+        const Reg mx = V::load (row (mix)), stGain = V::load (row (stageGain));
+        const Reg uThr = V::load (row (upThreshold)), uSlp = V::load (row (upSlope));
+        const Reg uAtt = V::load (row (upAttack)), uRel = V::load (row (upRelease));
+        const Reg uMx = V::load (row (upMix)), uStGain = V::load (row (upStageGain));
+
+        const Reg half = V::set (0.5f), minKnee = V::set (1.0e-6f);
+        const Reg halfKnee = V::mul (V::load (row (knee)), half), invKnee = V::div1 (V::max (V::load (row (knee)), minKnee));
+        const Reg uHalfKnee = V::mul (V::load (row (upKnee)), half), uInvKnee = V::div1 (V::max (V::load (row (upKnee)), minKnee));
+
+        Reg c[numEqStages][5];
+        for (int s = 0; s < numEqStages; ++s)
+            for (int k = 0; k < 5; ++k)
+                c[s][k] = V::load (row (eqCoeffs + 5 * s + k));
+
+        Reg z[numEqPasses][numEqStages][2];
+        for (int p = 0; p < numEqPasses; ++p)
+            for (int s = 0; s < numEqStages; ++s)
+                for (int k = 0; k < 2; ++k)
+                    z[p][s][k] = V::load (row (eqState + 2 * (p * numEqStages + s) + k));
+
+        Reg e = V::load (row (env)), g = V::load (row (gain));
+        Reg ue = V::load (row (upEnv)), ug = V::load (row (upGain));
+
+        // Transposed direct-form II cascade, the same recurrence as the core's EQ
+        const auto eq = [&c, &z] (int pass, Reg x)
+        {
+            for (int s = 0; s < numEqStages; ++s)
+            {
+                const Reg y = V::madd (c[s][0], x, z[pass][s][0]);
+                z[pass][s][0] = V::sub (V::madd (c[s][1], x, z[pass][s][1]), V::mul (c[s][3], y));
+                z[pass][s][1] = V::sub (V::mul (c[s][2], x), V::mul (c[s][4], y));
+                x = y;
+            }
+            return x;
+        };
+
+        const Reg one = V::set (1.0f), detCoeff = V::set (0.99f), envFloor = V::set (1.0e-12f);
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            float* io = frames + n * numLanes + lane;
+            const Reg x = V::mul (V::load (io), inGain);
+
+            // Downwards: detector, curve, attack/release (CompressorStage.h)
+            const Reg sc = eq (0, x);
+            const Reg sc2 = V::mul (sc, sc);
+            e = V::max (envFloor, V::madd (V::sub (e, sc2), detCoeff, sc2));
+
+            const Reg target = M::dbToGain (V::sub (V::set (0.0f), M::curve (V::sub (M::meanSquareToDb (e), thr), slp, halfKnee, invKnee)));
+            g = V::madd (V::select (V::lt (target, g), att, rel), V::sub (g, target), target);
+
+            Reg wet = V::mul (V::mul (x, V::madd (g, mx, V::sub (one, mx))), stGain);
+
+            // Upwards on the downwards output
+            const Reg usc = eq (1, wet);
+            const Reg usc2 = V::mul (usc, usc);
+            ue = V::max (envFloor, V::madd (V::sub (ue, usc2), detCoeff, usc2));
+
+            const Reg uTarget = M::dbToGain (M::curve (V::sub (uThr, M::meanSquareToDb (ue)), uSlp, uHalfKnee, uInvKnee));
+            const Reg uCoeff = V::select (V::lt (ug, half), V::set (0.98f), V::select (V::gt (uTarget, ug), uAtt, uRel));
+            ug = V::madd (uCoeff, V::sub (ug, uTarget), uTarget);
+
+            wet = V::mul (V::mul (wet, V::madd (ug, uMx, V::sub (one, uMx))), uStGain);
+
+            V::store (io, V::mul (V::madd (V::sub (wet, x), gMix, x), outGain));
+        }
+
+        for (int p = 0; p < numEqPasses; ++p)
+            for (int s = 0; s < numEqStages; ++s)
+                for (int k = 0; k < 2; ++k)
+                    V::store (row (eqState + 2 * (p * numEqStages + s) + k), z[p][s][k]);
+
+        V::store (row (env), e);  V::store (row (gain), g);
+        V::store (row (upEnv), ue); V::store (row (upGain), ug);
+    }
+}
+
+//==============================================================================
+// One lane at a time: the scalar level, and the reference for the others
+struct ScalarVec
+{
+    using Reg = float;
+    using Mask = bool;
+    static constexpr int width = 1;
+
+    static inline Reg load (const float* p) noexcept           { return *p; }
+    static inline void store (float* p, Reg v) noexcept        { *p = v; }
+    static inline Reg loadu (const float* p) noexcept          { return *p; }
+    static inline void storeu (float* p, Reg v) noexcept       { *p = v; }
+    static inline Reg set (float v) noexcept                   { return v; }
+    static inline Reg add (Reg a, Reg b) noexcept              { return a + b; }
+    static inline Reg sub (Reg a, Reg b) noexcept              { return a - b; }
+    static inline Reg mul (Reg a, Reg b) noexcept              { return a * b; }
+    static inline Reg madd (Reg a, Reg b, Reg c) noexcept      { return a * b + c; }
+    static inline Reg div1 (Reg a) noexcept                    { return 1.0f / a; }
+    static inline Reg min (Reg a, Reg b) noexcept              { return a < b ? a : b; }
+    static inline Reg max (Reg a, Reg b) noexcept              { return a > b ? a : b; }
+    static inline Mask lt (Reg a, Reg b) noexcept              { return a < b; }
+    static inline Mask gt (Reg a, Reg b) noexcept              { return a > b; }
+    static inline Reg select (Mask m, Reg a, Reg b) noexcept   { return m ? a : b; }
+
+    static inline Reg floor (Reg x) noexcept
+    {
+        const float t = (float) (int) x;
+        return t > x ? t - 1.0f : t;
+    }
+
+    static inline Reg exponent (Reg x) noexcept
+    {
+        uint32_t bits;
+        std::memcpy (&bits, &x, sizeof (bits));
+        return (float) ((int) (bits >> 23) - 127);
+    }
+
+    static inline Reg mantissa (Reg x) noexcept
+    {
+        uint32_t bits;
+        std::memcpy (&bits, &x, sizeof (bits));
+        bits = (bits & 0x007fffffu) | 0x3f800000u;
+        float m;
+        std::memcpy (&m, &bits, sizeof (m));
+        return m;
+    }
+
+    static inline Reg pow2 (Reg n) noexcept
+    {
+        const uint32_t bits = (uint32_t) ((int) n + 127) << 23;
+        float r;
+        std::memcpy (&r, &bits, sizeof (r));
+        return r;
+    }
+};
+}
+}
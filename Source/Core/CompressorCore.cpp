@@ -0,0 +1,1017 @@
+#include "CompressorCore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+namespace ultradyn
+{
+//==============================================================================
+namespace
+{
+    // Same ranges and defaults as the plugin's parameter layout
+    const CompressorCore::ParameterInfo parameterInfo[ULTRADYN_NUM_PARAMS] =
+    {
+        { "INPUT_GAIN",          -24.0f,    24.0f,     0.0f },
+        { "OUTPUT_GAIN",         -24.0f,    24.0f,     0.0f },
+        { "GLOBAL_MIX",            0.0f,   100.0f,   100.0f },
+        { "THRESHOLD",           -60.0f,     0.0f,   -24.0f },
+        { "RATIO",                 1.0f,    20.0f,     4.0f },
+        { "ATTACK",                0.1f,   100.0f,    10.0f },
+        { "RELEASE",               5.0f,  1000.0f,   100.0f },
+        { "KNEE",                  0.0f,    24.0f,     6.0f },
+        { "MIX",                   0.0f,   100.0f,   100.0f },
+        { "DOWNWARDS_OUTPUT",    -24.0f,    24.0f,     0.0f },
+        { "DOWNWARDS_BYPASS",      0.0f,     1.0f,     0.0f },
+        { "VOCAL_MODE",            0.0f,     1.0f,     0.0f },
+        { "DRUMBUS_MODE",          0.0f,     1.0f,     0.0f },
+        { "SC_HPF_FREQ",          20.0f,  1000.0f,    20.0f },
+        { "SC_LOW_SHELF_FREQ",    40.0f,  1000.0f,   150.0f },
+        { "SC_LOW_SHELF_GAIN",   -12.0f,    12.0f,     0.0f },
+        { "SC_PEAK_FREQ",        200.0f, 10000.0f,  1500.0f },
+        { "SC_PEAK_GAIN",        -12.0f,    12.0f,     0.0f },
+        { "SC_PEAK_Q",             0.3f,     6.0f,  0.7071f },
+        { "SC_HIGH_SHELF_FREQ", 1000.0f, 16000.0f,  6000.0f },
+        { "SC_HIGH_SHELF_GAIN",  -12.0f,    12.0f,     0.0f },
+        { "UPWARDS_THRESHOLD",   -60.0f,     0.0f,   -40.0f },
+        { "UPWARDS_RATIO",         1.0f,    10.0f,     2.0f },
+        { "UPWARDS_ATTACK",        0.1f,   100.0f,     5.0f },
+        { "UPWARDS_RELEASE",       5.0f,  1000.0f,    50.0f },
+        { "UPWARDS_KNEE",          0.0f,    24.0f,     3.0f },
+        { "UPWARDS_MIX",           0.0f,   100.0f,   100.0f },
+        { "UPWARDS_OUTPUT",      -24.0f,    24.0f,     0.0f },
+        { "UPWARDS_BYPASS",        0.0f,     1.0f,     0.0f },
+        { "UPWARDS_FIRST",         0.0f,     1.0f,     0.0f },
+        { "CONTROL_RATE",          0.0f,     1.0f,     0.0f },
+        { "TRUE_PEAK_LIMITER",     0.0f,     1.0f,     0.0f },
+        { "LIMITER_CEILING",     -12.0f,     0.0f,    -1.0f },
+        { "LIMITER_RELEASE",      10.0f,  1000.0f,   100.0f },
+        { "AUTO_QUALITY",          0.0f,     1.0f,     0.0f },
+        { "CPU_BUDGET",            1.0f,    50.0f,     5.0f },
+        { "LINK_GROUP",            0.0f,    16.0f,     0.0f },
+        { "LINK_MODE",             0.0f,     1.0f,     0.0f },
+        { "SPECTRAL_MODE",         0.0f,     1.0f,     0.0f },
+        { "RENDER_PROFILE",        0.0f,     1.0f,     1.0f },
+        { "CHANNEL_THREADS",       0.0f,     2.0f,     0.0f },
+        { "STAGE2_PARALLEL",       0.0f,     1.0f,     0.0f },
+        { "STAGE3_TYPE",           0.0f,     3.0f,     0.0f },
+        { "STAGE3_PARALLEL",       0.0f,     1.0f,     0.0f },
+        { "STAGE3_THRESHOLD",    -60.0f,     0.0f,   -12.0f },
+        { "STAGE3_RATIO",          1.0f,    20.0f,     4.0f },
+        { "STAGE3_ATTACK",         0.1f,   100.0f,     1.0f },
+        { "STAGE3_RELEASE",        5.0f,  1000.0f,    50.0f },
+        { "STAGE3_KNEE",           0.0f,    24.0f,     0.0f },
+        { "STAGE3_MIX",            0.0f,   100.0f,   100.0f },
+        { "STAGE3_OUTPUT",       -24.0f,    24.0f,     0.0f },
+        { "STAGE4_TYPE",           0.0f,     3.0f,     0.0f },
+        { "STAGE4_PARALLEL",       0.0f,     1.0f,     0.0f },
+        { "STAGE4_THRESHOLD",    -60.0f,     0.0f,    -6.0f },
+        { "STAGE4_RATIO",          1.0f,    20.0f,     4.0f },
+        { "STAGE4_ATTACK",         0.1f,   100.0f,     1.0f },
+        { "STAGE4_RELEASE",        5.0f,  1000.0f,    50.0f },
+        { "STAGE4_KNEE",           0.0f,    24.0f,     0.0f },
+        { "STAGE4_MIX",            0.0f,   100.0f,   100.0f },
+        { "STAGE4_OUTPUT",       -24.0f,    24.0f,     0.0f },
+    };
+
+    // Each stage slot's parameters; the limiter uses threshold, release, mix and output
+    struct StageParams
+    {
+        ultradyn_param threshold, ratio, attack, release, knee, mix, output;
+    };
+
+    const StageParams stageParams[CompressorCore::maxStages] =
+    {
+        { ULTRADYN_PARAM_THRESHOLD, ULTRADYN_PARAM_RATIO, ULTRADYN_PARAM_ATTACK, ULTRADYN_PARAM_RELEASE,
+          ULTRADYN_PARAM_KNEE, ULTRADYN_PARAM_MIX, ULTRADYN_PARAM_DOWNWARDS_OUTPUT },
+        { ULTRADYN_PARAM_UPWARDS_THRESHOLD, ULTRADYN_PARAM_UPWARDS_RATIO, ULTRADYN_PARAM_UPWARDS_ATTACK, ULTRADYN_PARAM_UPWARDS_RELEASE,
+          ULTRADYN_PARAM_UPWARDS_KNEE, ULTRADYN_PARAM_UPWARDS_MIX, ULTRADYN_PARAM_UPWARDS_OUTPUT },
+        { ULTRADYN_PARAM_STAGE3_THRESHOLD, ULTRADYN_PARAM_STAGE3_RATIO, ULTRADYN_PARAM_STAGE3_ATTACK, ULTRADYN_PARAM_STAGE3_RELEASE,
+          ULTRADYN_PARAM_STAGE3_KNEE, ULTRADYN_PARAM_STAGE3_MIX, ULTRADYN_PARAM_STAGE3_OUTPUT },
+        { ULTRADYN_PARAM_STAGE4_THRESHOLD, ULTRADYN_PARAM_STAGE4_RATIO, ULTRADYN_PARAM_STAGE4_ATTACK, ULTRADYN_PARAM_STAGE4_RELEASE,
+          ULTRADYN_PARAM_STAGE4_KNEE, ULTRADYN_PARAM_STAGE4_MIX, ULTRADYN_PARAM_STAGE4_OUTPUT },
+    };
+
+    // Exact dB conversions for the per-block gains and meters, with the
+    // -100 dB floor of juce::Decibels
+    inline float decibelsToGain (float dB) noexcept
+    {
+        return dB > -100.0f ? std::pow (10.0f, dB * 0.05f) : 0.0f;
+    }
+
+    inline float peakToMeterDb (float peak) noexcept
+    {
+        return peak > 0.0f ? std::max (-100.0f, 20.0f * std::log10 (peak)) : -60.0f;
+    }
+
+    inline void applyGain (float* data, int numSamples, float gain) noexcept
+    {
+        if (gain == 1.0f)
+            return;
+
+        for (int i = 0; i < numSamples; ++i)
+            data[i] *= gain;
+    }
+}
+
+const CompressorCore::ParameterInfo* CompressorCore::getParameterInfo (int index) noexcept
+{
+    return index >= 0 && index < ULTRADYN_NUM_PARAMS ? &parameterInfo[index] : nullptr;
+}
+
+//==============================================================================
+CompressorCore::CompressorCore()
+{
+    for (int i = 0; i < ULTRADYN_NUM_PARAMS; ++i)
+        params[i].store (parameterInfo[i].defaultValue, std::memory_order_relaxed);
+
+    tables = SharedTables::get (sampleRate); // replaced in prepare
+    prepare (sampleRate, 2);
+}
+
+void CompressorCore::prepare (double newSampleRate, int numChannels)
+{
+    sampleRate = std::max (1.0, newSampleRate);
+
+    numChannels = std::max (1, numChannels);
+    tables = SharedTables::get (sampleRate);
+
+    // Pick the widest kernels this CPU supports (ULTRADYN_ISA or setOverride force one)
+    dsp = &kernels::select();
+    for (auto& eq : hot.scEQ)
+        eq.setKernel (dsp->biquadCascade);
+    for (auto& h : histograms)
+        h.prepare (sampleRate);
+
+    channelWorkers.stop();
+    int maxTasks = 1;
+    if (numChannels >= minParallelChannels)
+    {
+        const int hardwareThreads = (int) std::thread::hardware_concurrency();
+        maxTasks += std::max (0, std::min ({ maxChannelWorkers, numChannels / channelsPerTask - 1, hardwareThreads - 1 }));
+    }
+
+    // Every buffer the audio thread works in, in one block: scratch for one
+    // internal sub-block (whatever block size the caller uses) in the order
+    // process() goes through it, one sub-block of limiter peaks per task the
+    // channels could be split into, then the limiter's and the spectral
+    // mode's buffers
+    ScratchArena::Layout layout;
+    layout.reserve (monoScratch, maxSubBlockSize);
+    layout.reserve (scScratch, maxSubBlockSize);
+    layout.reserve (chainScratch, maxSubBlockSize);
+    layout.reserve (envScratch, maxSubBlockSize);
+    layout.reserve (peakScratch, maxSubBlockSize);
+    for (auto& g : gainScratch)
+        layout.reserve (g, maxSubBlockSize);
+    layout.reserve (wetChannels, (size_t) numChannels);
+    layout.reserve (wetStorage, (size_t) numChannels * maxSubBlockSize);
+    layout.reserve (taskLimiterPeaks, (size_t) maxTasks * maxSubBlockSize);
+    limiter.prepare (sampleRate, numChannels, maxSubBlockSize, *dsp, layout);
+    spectral.prepare (numChannels, maxSubBlockSize, *dsp, layout);
+    scratch.allocate (layout);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        wetChannels[(size_t) ch] = wetStorage.data() + (size_t) ch * maxSubBlockSize;
+
+    updateLink();
+    updateChannelThreads();
+    reset();
+}
+
+void CompressorCore::reset() noexcept
+{
+    for (auto& eq : hot.scEQ)
+        eq.reset();
+
+    // Initialize envelope followers to prevent pops when audio starts
+    for (auto& stage : hot.stages)
+    {
+        stage.env = 1.0e-12f;
+        stage.smoothGain = 1.0f;
+        stage.initialRamp = true; // Reset initial ramp mode
+    }
+    hot.upwardsStartupDelay = 0; // Reset startup delay
+    hot.audioIsActive = false; // Reset audio active state
+    hot.audioInactiveCounter = 0; // Reset inactive counter
+    hot.limiterEnabled = param (ULTRADYN_PARAM_TRUE_PEAK_LIMITER) > 0.5f;
+    limiter.reset();
+    hot.spectralEnabled = param (ULTRADYN_PARAM_SPECTRAL_MODE) > 0.5f;
+    spectral.reset();
+
+    // Start at full quality; the first blocks after a reset run on cold caches
+    hot.qualityTier = 0;
+    hot.load = 0.0f;
+    hot.tierHoldSamples = (int) (0.5 * sampleRate);
+    hot.headroomSamples = 0;
+    meters.qualityTier.store (0);
+    meters.grDb.store (0.0f);
+    meters.upwardsGainDb.store (0.0f);
+
+    // Snap all coefficients, no glide
+    hot.vocalModeEnabled = param (ULTRADYN_PARAM_VOCAL_MODE) > 0.5f;
+    hot.drumbusModeEnabled = param (ULTRADYN_PARAM_DRUMBUS_MODE) > 0.5f && ! hot.vocalModeEnabled;
+    timeConstantsDirty = false;
+    sidechainEQDirty = false;
+    updateTimeConstants (0);
+    updateSidechainEQ (0);
+}
+
+void CompressorCore::setParameter (int index, float value) noexcept
+{
+    if (index < 0 || index >= ULTRADYN_NUM_PARAMS || value != value)
+        return;
+
+    const auto& info = parameterInfo[index];
+    params[index].store (std::min (std::max (value, info.minValue), info.maxValue), std::memory_order_relaxed);
+
+    // May be called from any thread, including the audio thread during automation
+    switch (index)
+    {
+        case ULTRADYN_PARAM_ATTACK:
+        case ULTRADYN_PARAM_RELEASE:
+        case ULTRADYN_PARAM_UPWARDS_ATTACK:
+        case ULTRADYN_PARAM_UPWARDS_RELEASE:
+        case ULTRADYN_PARAM_STAGE3_ATTACK:
+        case ULTRADYN_PARAM_STAGE3_RELEASE:
+        case ULTRADYN_PARAM_STAGE4_ATTACK:
+        case ULTRADYN_PARAM_STAGE4_RELEASE:
+            timeConstantsDirty = true;
+            break;
+
+        case ULTRADYN_PARAM_THRESHOLD:
+        case ULTRADYN_PARAM_VOCAL_MODE:
+        case ULTRADYN_PARAM_DRUMBUS_MODE:
+        case ULTRADYN_PARAM_SC_HPF_FREQ:
+        case ULTRADYN_PARAM_SC_LOW_SHELF_FREQ:
+        case ULTRADYN_PARAM_SC_LOW_SHELF_GAIN:
+        case ULTRADYN_PARAM_SC_PEAK_FREQ:
+        case ULTRADYN_PARAM_SC_PEAK_GAIN:
+        case ULTRADYN_PARAM_SC_PEAK_Q:
+        case ULTRADYN_PARAM_SC_HIGH_SHELF_FREQ:
+        case ULTRADYN_PARAM_SC_HIGH_SHELF_GAIN:
+            sidechainEQDirty = true;
+            break;
+
+        default:
+            break;
+    }
+}
+
+float CompressorCore::getParameter (int index) const noexcept
+{
+    return index >= 0 && index < ULTRADYN_NUM_PARAMS ? params[index].load (std::memory_order_relaxed) : 0.0f;
+}
+
+bool CompressorCore::updateLink()
+{
+    // Groups are named by number; the name is what other processes match
+    const int group = (int) std::lround (param (ULTRADYN_PARAM_LINK_GROUP));
+    if (group <= 0)
+    {
+        link.setGroup (nullptr);
+        return true;
+    }
+
+    char name[16];
+    std::snprintf (name, sizeof (name), "%d", group);
+    LinkGroup* g = joinLinkGroup (name);
+    link.setGroup (g);
+    return g != nullptr;
+}
+
+int CompressorCore::updateChannelThreads()
+{
+    // Stopping them again could race a process() call still using them
+    const int maxWorkers = (int) (taskLimiterPeaks.size() / maxSubBlockSize) - 1;
+    if (param (ULTRADYN_PARAM_CHANNEL_THREADS) > 0.5f && maxWorkers > 0 && channelWorkers.getNumWorkers() == 0)
+        channelWorkers.start (maxWorkers);
+
+    return channelWorkers.getNumWorkers();
+}
+
+int CompressorCore::getLatencySamples() const noexcept
+{
+    return (param (ULTRADYN_PARAM_TRUE_PEAK_LIMITER) > 0.5f ? limiter.getLatencySamples() : 0)
+         + (param (ULTRADYN_PARAM_SPECTRAL_MODE) > 0.5f ? spectral.getLatencySamples() : 0);
+}
+
+ultradyn_meters CompressorCore::getMeters() const noexcept
+{
+    ultradyn_meters m;
+    m.gainReductionDb = meters.grDb.load (std::memory_order_relaxed);
+    m.upwardsGainDb   = meters.upwardsGainDb.load (std::memory_order_relaxed);
+    m.inputLevelDb    = meters.inputLevel.load (std::memory_order_relaxed);
+    m.outputLevelDb   = meters.outputLevel.load (std::memory_order_relaxed);
+    return m;
+}
+
+size_t CompressorCore::getMemoryFootprintBytes() const noexcept
+{
+    size_t bytes = sizeof (*this);
+    bytes += scratch.getSizeInBytes();
+    bytes += spectral.getMemoryFootprintBytes();
+    bytes += analyzerTap.getMemoryFootprintBytes();
+
+    if (tables != nullptr)
+        bytes += tables->getSizeInBytes() / (size_t) std::max (1L, (long) tables.use_count());
+
+    return bytes;
+}
+
+//==============================================================================
+void CompressorCore::resetHistograms() noexcept
+{
+    for (auto& h : histograms)
+        h.requestReset();
+}
+
+float CompressorCore::suggestThreshold (int stage, float percentOfTime) const noexcept
+{
+    const auto thresholdParam = stage == 0 ? ULTRADYN_PARAM_THRESHOLD : ULTRADYN_PARAM_UPWARDS_THRESHOLD;
+    const auto& info = parameterInfo[thresholdParam];
+
+    uint32_t counts[LevelHistogram::numBins];
+    if (histograms[stage].read (counts) == 0)
+        return param (thresholdParam);
+
+    // Downwards works above the threshold, upwards below it
+    const float share = std::min (1.0f, std::max (0.0f, percentOfTime * 0.01f));
+    const float level = LevelHistogram::percentileDb (counts, stage == 0 ? 1.0f - share : share);
+    return std::min (info.maxValue, std::max (info.minValue, level));
+}
+
+float CompressorCore::suggestThresholdForGain (int stage, float averageDb) const noexcept
+{
+    const bool upwards = stage != 0;
+    const auto thresholdParam = upwards ? ULTRADYN_PARAM_UPWARDS_THRESHOLD : ULTRADYN_PARAM_THRESHOLD;
+    const auto& info = parameterInfo[thresholdParam];
+
+    uint32_t counts[LevelHistogram::numBins];
+    if (histograms[stage].read (counts) == 0)
+        return param (thresholdParam);
+
+    const auto settings = upwards ? StageSettings::make (0.0f, param (ULTRADYN_PARAM_UPWARDS_RATIO), param (ULTRADYN_PARAM_UPWARDS_KNEE), 1.0f, 1.0f)
+                                  : StageSettings::make (0.0f, param (ULTRADYN_PARAM_RATIO), param (ULTRADYN_PARAM_KNEE), 1.0f, 1.0f);
+    return LevelHistogram::thresholdForAverageDb (counts, upwards ? StageDirection::upwards : StageDirection::downwards,
+                                                  settings, averageDb, info.minValue, info.maxValue);
+}
+
+//==============================================================================
+void CompressorCore::updateTimeConstants (int rampSamples) noexcept
+{
+    for (int slot = 0; slot < maxStages; ++slot)
+    {
+        auto& stage = hot.stages[slot];
+        const float attackMs  = param (stageParams[slot].attack);
+        const float releaseMs = param (stageParams[slot].release);
+
+        // exp (-1 / (ms * 0.001 * sr + 1)), tabulated per sample rate
+        stage.attackCoeff.rampTo  (tables->timeConstantToCoeff (attackMs),  rampSamples);
+        stage.releaseCoeff.rampTo (tables->timeConstantToCoeff (releaseMs), rampSamples);
+
+        // Control-rate interval: a sixteenth of the faster time constant, 4..32 samples
+        stage.controlInterval = std::min (32, std::max (4, (int) (std::min (attackMs, releaseMs) * 0.001 * sampleRate / 16.0)));
+    }
+}
+
+void CompressorCore::updateSidechainEQ (int rampSamples) noexcept
+{
+    using Coeffs = BiquadCoeffs;
+    const double sr = sampleRate;
+
+    // High-pass: the lowest setting switches the stage off
+    const float hpfFreq = param (ULTRADYN_PARAM_SC_HPF_FREQ);
+
+    // Peak: user gain plus the vocal/drumbus offset, which boosts (vocal) or
+    // cuts (drumbus) up to 5 dB as the threshold lowers
+    float modeDb = 0.0f;
+    if (hot.vocalModeEnabled || hot.drumbusModeEnabled)
+    {
+        const float thresholdMin = -60.0f;
+        const float thresholdMax = 0.0f;
+        const float thr = param (ULTRADYN_PARAM_THRESHOLD);
+        const float tNorm = std::min (1.0f, std::max (0.0f, (thresholdMax - thr) / (thresholdMax - thresholdMin)));
+        modeDb = tNorm * (hot.vocalModeEnabled ? 5.0f : -5.0f);
+    }
+
+    const Coeffs stages[SidechainEQ::numStages] =
+    {
+        hpfFreq > 20.5f ? Coeffs::highPass (sr, hpfFreq, 0.7071f) : Coeffs::identity(),
+        Coeffs::lowShelf (sr, param (ULTRADYN_PARAM_SC_LOW_SHELF_FREQ), param (ULTRADYN_PARAM_SC_LOW_SHELF_GAIN)),
+        Coeffs::peak (sr, param (ULTRADYN_PARAM_SC_PEAK_FREQ), param (ULTRADYN_PARAM_SC_PEAK_Q),
+                      param (ULTRADYN_PARAM_SC_PEAK_GAIN) + modeDb),
+        Coeffs::highShelf (sr, param (ULTRADYN_PARAM_SC_HIGH_SHELF_FREQ), param (ULTRADYN_PARAM_SC_HIGH_SHELF_GAIN))
+    };
+
+    // Every chain position's detector uses the same EQ, each with its own filter state
+    for (auto& eq : hot.scEQ)
+    {
+        for (int s = 0; s < SidechainEQ::numStages; ++s)
+            eq.setStage (s, stages[s]);
+
+        eq.commit (rampSamples);
+    }
+}
+
+//==============================================================================
+void CompressorCore::runUpwardsDetector (StageState& state, const float* scData, float* env, int numSamples) noexcept
+{
+    int n = 0;
+
+    // Use a very slow initial ramp to prevent sudden jumps when audio starts
+    for (; state.initialRamp && n < numSamples; ++n)
+    {
+        const float x2 = scData[n] * scData[n];
+        state.env = std::max (1.0e-12f, x2 * 0.001f + state.env * 0.999f);
+        if (state.env > 1.0e-6f) state.initialRamp = false; // Switch to normal mode once we have some signal
+        env[n] = state.env;
+    }
+
+    // Normal response
+    if (n < numSamples)
+        dsp->rmsEnvelope (scData + n, env + n, numSamples - n, 0.99f, state.env);
+}
+
+CompressorCore::StageType CompressorCore::getStageType (int slot) const noexcept
+{
+    switch (slot)
+    {
+        case 0:  return StageType::downwards;
+        case 1:  return StageType::upwards;
+        case 2:  return (StageType) std::lround (param (ULTRADYN_PARAM_STAGE3_TYPE));
+        default: return (StageType) std::lround (param (ULTRADYN_PARAM_STAGE4_TYPE));
+    }
+}
+
+void CompressorCore::computeStageGains (int slot, StageType type, const float* scData, float* gains, int numSamples, float stageGain) noexcept
+{
+    auto& state = hot.stages[slot];
+    const auto& p = stageParams[slot];
+
+    const auto settings = StageSettings::make (param (p.threshold), param (p.ratio), param (p.knee), param (p.mix) * 0.01f, stageGain);
+
+    if (type == StageType::limiter)
+    {
+        // scData is the sample peak here, not a sidechain to square
+        ultradyn::computeLimiterGains (state, settings, decibelsToGain (settings.threshold), scData, gains, numSamples);
+    }
+    else if (type != StageType::upwards)
+    {
+        dsp->rmsEnvelope (scData, envScratch.data(), numSamples, 0.99f, state.env);
+
+        // Only the downwards stage is counted and linked, not STAGE3/4
+        if (slot == 0)
+            histograms[0].add (envScratch.data(), numSamples);
+
+        // Linked: publish the own level, compress on the group's. The
+        // detector state itself stays this instance's own.
+        if (slot == 0 && hot.linked)
+        {
+            hot.linkLevel = std::max (hot.linkLevel, dsp->peakAbs (envScratch.data(), numSamples));
+
+            if (hot.linkSum)
+            {
+                for (int n = 0; n < numSamples; ++n)
+                    envScratch[n] += hot.linkOthersSum;
+            }
+            else
+            {
+                for (int n = 0; n < numSamples; ++n)
+                    envScratch[n] = std::max (envScratch[n], hot.linkOthersLoudest);
+            }
+        }
+
+        ultradyn::computeStageGains<StageDirection::downwards> (state, settings, *tables, *dsp, envScratch.data(),
+                                                                gains, numSamples, hot.controlRateGain);
+    }
+    else
+    {
+        // RMS detector with much slower initial response to prevent pops
+        runUpwardsDetector (state, scData, envScratch.data(), numSamples);
+        if (slot == 1)
+            histograms[1].add (envScratch.data(), numSamples);
+
+        ultradyn::computeStageGains<StageDirection::upwards> (state, settings, *tables, *dsp, envScratch.data(),
+                                                              gains, numSamples, hot.controlRateGain);
+    }
+}
+
+//==============================================================================
+void CompressorCore::process (float* const* channels, int numChannels, int numSamples) noexcept
+{
+    kernels::ScopedFlushDenormals noDenormals;
+    const int numCh = std::min (numChannels, (int) wetChannels.size());
+
+    // Callers may deliver anything from 1 sample to several seconds; work
+    // through it in fixed sub-blocks so scratch memory stays bounded and
+    // parameters are picked up at a fixed control rate
+    float inputPeak = 0.0f;
+    float outputPeak = 0.0f;
+
+    // Offline, the render profile may overrule the live engine choices; the
+    // tier drops back to 0 below and the gain computers go per sample
+    hot.rendering = nonRealtime.load (std::memory_order_relaxed) && param (ULTRADYN_PARAM_RENDER_PROFILE) > 0.5f;
+
+    using Clock = std::chrono::steady_clock;
+    const bool autoQuality = param (ULTRADYN_PARAM_AUTO_QUALITY) > 0.5f && ! hot.rendering;
+    const auto started = autoQuality ? Clock::now() : Clock::time_point();
+
+    // The other linked instances' levels hold for the whole call; ours goes
+    // out once it is done, for them to pick up in their next call
+    hot.linked = link.begin (hot.linkOthersLoudest, hot.linkOthersSum);
+    hot.linkSum = param (ULTRADYN_PARAM_LINK_MODE) > 0.5f;
+    hot.linkLevel = 0.0f;
+
+    // Channel threads (mode 1 offline only, 2 always), for wide buses and
+    // blocks long enough to pay for the hand-offs
+    const int threadMode = (int) std::lround (param (ULTRADYN_PARAM_CHANNEL_THREADS));
+    const bool useThreads = (threadMode == 2 || (threadMode == 1 && nonRealtime.load (std::memory_order_relaxed)))
+                            && numCh >= minParallelChannels && numSamples >= maxSubBlockSize;
+    hot.numTasks = useThreads ? channelWorkers.getNumWorkers() + 1 : 1;
+
+    for (int start = 0; start < numSamples; start += maxSubBlockSize)
+        processSubBlock (channels, numCh, start, std::min (maxSubBlockSize, numSamples - start), inputPeak, outputPeak);
+
+    if (hot.linked)
+        link.publish (hot.linkLevel);
+
+    if (autoQuality)
+        updateQualityTier (std::chrono::duration<double> (Clock::now() - started).count(), numSamples);
+    else
+        setQualityTier (0);
+
+    meters.inputLevel.store (peakToMeterDb (inputPeak), std::memory_order_relaxed);
+    meters.outputLevel.store (peakToMeterDb (outputPeak), std::memory_order_relaxed);
+}
+
+// Steps down a tier as soon as the filtered load goes over the budget (at most
+// every half second, so each step shows in the load first), and back up after
+// two seconds below a third of it: the control-rate tier costs roughly 40% of
+// the per-sample one, so stepping up from there should not cross the budget
+void CompressorCore::updateQualityTier (double processSeconds, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    const float proportion = (float) (processSeconds * sampleRate / (double) numSamples);
+    hot.load += 0.2f * (proportion - hot.load);
+
+    const float budget = param (ULTRADYN_PARAM_CPU_BUDGET) * 0.01f;
+    const int holdSamples = (int) (0.5 * sampleRate);
+
+    hot.tierHoldSamples = std::max (0, hot.tierHoldSamples - numSamples);
+    int tier = hot.qualityTier;
+
+    if (hot.load > budget)
+    {
+        hot.headroomSamples = 0;
+        if (hot.tierHoldSamples == 0 && tier < ULTRADYN_NUM_QUALITY_TIERS - 1)
+        {
+            ++tier;
+            hot.tierHoldSamples = holdSamples;
+        }
+    }
+    else if (hot.load < budget * (1.0f / 3.0f) && tier > 0)
+    {
+        hot.headroomSamples += numSamples;
+        if (hot.headroomSamples >= (int) (2.0 * sampleRate))
+        {
+            --tier;
+            hot.headroomSamples = 0;
+            hot.tierHoldSamples = holdSamples;
+        }
+    }
+    else
+    {
+        hot.headroomSamples = 0;
+    }
+
+    setQualityTier (tier);
+}
+
+void CompressorCore::setQualityTier (int tier) noexcept
+{
+    if (tier == hot.qualityTier)
+        return;
+
+    hot.qualityTier = tier;
+    meters.qualityTier.store (tier, std::memory_order_relaxed);
+}
+
+template <typename Job>
+void CompressorCore::forEachTask (Job&& job) noexcept
+{
+    if (hot.numTasks > 1)
+        channelWorkers.run (job);
+    else
+        job (0);
+}
+
+void CompressorCore::processSubBlock (float* const* channels, int numCh, int startSample, int numSamples,
+                                      float& inputPeak, float& outputPeak) noexcept
+{
+    // Check if vocal mode and drumbus mode are enabled (mutually exclusive)
+    hot.vocalModeEnabled = param (ULTRADYN_PARAM_VOCAL_MODE) > 0.5f;
+    hot.drumbusModeEnabled = param (ULTRADYN_PARAM_DRUMBUS_MODE) > 0.5f && ! hot.vocalModeEnabled;
+    hot.controlRateGain = (param (ULTRADYN_PARAM_CONTROL_RATE) > 0.5f || hot.qualityTier >= 1) && ! hot.rendering;
+
+    // Recompute coefficients only on change, gliding to the new values across this sub-block
+    if (timeConstantsDirty.exchange (false))
+        updateTimeConstants (numSamples);
+    if (sidechainEQDirty.exchange (false))
+        updateSidechainEQ (numSamples);
+
+    // Reset envelope followers if they're in an invalid state to prevent pops
+    for (auto& stage : hot.stages)
+        if (stage.env < 1.0e-12f) stage.env = 1.0e-12f;
+
+    const int numTasks = hot.numTasks;
+    const bool spectralMode = param (ULTRADYN_PARAM_SPECTRAL_MODE) > 0.5f;
+
+    // Input gain, input level (after input gain), the wet copy (scratch is
+    // preallocated for a full sub-block, never resized here) and the mono sum
+    // both broadband sidechains derive from, plus the loudest channel per
+    // sample when a limiter stage is on. Split by sample ranges, so the mono
+    // sum adds the channels up in the same order however many tasks.
+    const float inGain = decibelsToGain (param (ULTRADYN_PARAM_INPUT_GAIN));
+    const bool limiterStages = ! spectralMode && (getStageType (2) == StageType::limiter
+                                                  || getStageType (3) == StageType::limiter);
+    forEachTask ([&] (int task)
+    {
+        const int from = (numSamples * task / numTasks) & ~15;
+        const int to = task + 1 < numTasks ? (numSamples * (task + 1) / numTasks) & ~15 : numSamples;
+
+        float peak = 0.0f;
+        if (to > from)
+        {
+            float* samplePeaks = peakScratch.data() + from;
+            if (limiterStages)
+                std::fill (samplePeaks, samplePeaks + (to - from), 0.0f);
+
+            for (int ch = 0; ch < numCh; ++ch)
+            {
+                float* data = channels[ch] + startSample + from;
+                applyGain (data, to - from, inGain);
+                peak = std::max (peak, dsp->peakAbs (data, to - from));
+                std::memcpy (wetChannels[(size_t) ch] + from, data, (size_t) (to - from) * sizeof (float));
+
+                if (limiterStages)
+                    for (int i = 0; i < to - from; ++i)
+                        samplePeaks[i] = std::max (samplePeaks[i], std::abs (data[i]));
+            }
+
+            if (! spectralMode)
+                dsp->sumToMono (monoScratch.data() + from, channels, numCh, startSample + from, to - from);
+        }
+
+        taskLevels[task] = peak;
+    });
+
+    const float subBlockPeak = *std::max_element (taskLevels, taskLevels + numTasks);
+    inputPeak = std::max (inputPeak, subBlockPeak);
+
+    // Detect audio activity (threshold at -60dB)
+    const bool hasAudio = subBlockPeak > 1.0e-3f; // -60dB threshold
+    if (hasAudio)
+    {
+        hot.audioInactiveCounter = 0; // Reset inactive counter
+        if (! hot.audioIsActive)
+        {
+            hot.audioIsActive = true;
+            hot.upwardsStartupDelay = 0; // Reset startup delay when audio starts
+        }
+    }
+    else
+    {
+        hot.audioInactiveCounter += numSamples;
+        if (hot.audioInactiveCounter > DEACTIVATION_THRESHOLD)
+        {
+            hot.audioIsActive = false; // Deactivate after 50ms of silence
+            hot.upwardsStartupDelay = 0; // Reset startup delay
+            // Reset upwards compressor state when audio becomes inactive
+            for (int slot = 0; slot < maxStages; ++slot)
+            {
+                if (getStageType (slot) == StageType::upwards)
+                {
+                    hot.stages[slot].env = 1.0e-12f;
+                    hot.stages[slot].smoothGain = 1.0f;
+                    hot.stages[slot].initialRamp = true;
+                }
+            }
+            meters.upwardsGainDb.store (0.0f);
+        }
+    }
+
+    // Spectral mode replaces the broadband chain; switching it on starts
+    // from silence in its frame buffers
+    if (spectralMode && ! hot.spectralEnabled)
+        spectral.reset();
+    hot.spectralEnabled = spectralMode;
+
+    const int numGainCurves = spectralMode ? processSpectral (channels, numCh, startSample, numSamples)
+                                           : processBroadband (numSamples);
+
+    // True-peak limiter; switching it on starts from silence in its delay line
+    const bool limiterEnabled = param (ULTRADYN_PARAM_TRUE_PEAK_LIMITER) > 0.5f;
+    if (limiterEnabled && ! hot.limiterEnabled)
+        limiter.reset();
+    hot.limiterEnabled = limiterEnabled;
+
+    // Per channel group: the stages' gains on the wet copy, global mix
+    // (wet/dry blend), global output gain (after global mix), then the
+    // limiter's detector or the output level
+    const float globalMix = param (ULTRADYN_PARAM_GLOBAL_MIX) * 0.01f; // 0..1
+    const float outGain = decibelsToGain (param (ULTRADYN_PARAM_OUTPUT_GAIN));
+    const bool interSample = hot.qualityTier < 2;
+    forEachTask ([&] (int task)
+    {
+        const int first = numCh * task / numTasks, last = numCh * (task + 1) / numTasks;
+
+        float peak = 0.0f;
+        for (int ch = first; ch < last; ++ch)
+        {
+            float* out = channels[ch] + startSample;
+            float* wet = wetChannels[(size_t) ch];
+
+            for (int curve = 0; curve < numGainCurves; ++curve)
+                dsp->applyGainCurve (wet, gainScratch[curve].data(), numSamples, 1.0f);
+
+            dsp->mixDryWet (out, out, wet, numSamples, globalMix);
+            applyGain (out, numSamples, outGain);
+
+            if (! limiterEnabled)
+                peak = std::max (peak, dsp->peakAbs (out, numSamples));
+        }
+
+        if (limiterEnabled)
+        {
+            float* peaks = taskLimiterPeaks.data() + (size_t) task * maxSubBlockSize;
+            std::fill (peaks, peaks + numSamples, 0.0f);
+            limiter.detect (channels, first, last, startSample, numSamples, interSample, peaks);
+        }
+
+        taskLevels[task] = peak;
+    });
+
+    // The limiter's gain follows the loudest channel of all groups
+    if (limiterEnabled)
+    {
+        float* peaks = taskLimiterPeaks.data();
+        for (int task = 1; task < numTasks; ++task)
+        {
+            const float* taskPeaks = peaks + (size_t) task * maxSubBlockSize;
+            for (int i = 0; i < numSamples; ++i)
+                peaks[i] = std::max (peaks[i], taskPeaks[i]);
+        }
+
+        limiter.computeGain (peaks, numSamples, decibelsToGain (param (ULTRADYN_PARAM_LIMITER_CEILING)),
+                             tables->timeConstantToCoeff (param (ULTRADYN_PARAM_LIMITER_RELEASE)));
+
+        forEachTask ([&] (int task)
+        {
+            const int first = numCh * task / numTasks, last = numCh * (task + 1) / numTasks;
+            limiter.apply (channels, first, last, startSample, numSamples);
+
+            float peak = 0.0f;
+            for (int ch = first; ch < last; ++ch)
+                peak = std::max (peak, dsp->peakAbs (channels[ch] + startSample, numSamples));
+
+            taskLevels[task] = peak;
+        });
+    }
+
+    // Measure the output level
+    outputPeak = std::max (outputPeak, *std::max_element (taskLevels, taskLevels + numTasks));
+
+    // scScratch still holds the first chain position's detector signal
+    analyzerTap.push (scScratch.data(), channels, numCh, startSample, numSamples);
+}
+
+int CompressorCore::processBroadband (int numSamples) noexcept
+{
+    // Combined gain of the stages that ran, per direction, for the meters
+    float downwardsGain = 1.0f, upwardsGain = 1.0f;
+    bool downwardsRan = false, upwardsRan = false, upwardsHeld = false;
+
+    // The open group of parallel stages: its first gain curve, its branches,
+    // and per direction the sum of their gains for the meters (1 for a branch
+    // of the other direction or one passing the signal through)
+    int groupStart = 0, groupBranches = 0;
+    float groupDownwards = 0.0f, groupUpwards = 0.0f;
+
+    // Each stage writes the gain it applies to gains and returns false when
+    // it passes the signal through untouched
+    const auto runStage = [&, this] (int slot, StageType type, const float* scData, float* gains)
+    {
+        ++groupBranches;
+
+        // Upwards stages only process while audio is active
+        const bool upwards = type == StageType::upwards;
+        if (upwards && ! hot.audioIsActive)
+        {
+            groupDownwards += 1.0f;
+            groupUpwards += 1.0f;
+            return false;
+        }
+
+        const float stageGain = decibelsToGain (param (stageParams[slot].output));
+
+        // Add startup delay to prevent initial surge
+        if (upwards && hot.upwardsStartupDelay < ACTIVATION_DELAY_SAMPLES)
+        {
+            upwardsHeld = true; // pass through without processing
+            std::fill (gains, gains + numSamples, stageGain);
+            groupDownwards += 1.0f;
+            groupUpwards += 1.0f;
+            return true;
+        }
+
+        computeStageGains (slot, type, scData, gains, numSamples, stageGain);
+
+        if (upwards)
+        {
+            groupUpwards += hot.stages[slot].smoothGain;
+            groupDownwards += 1.0f;
+            upwardsRan = true;
+        }
+        else
+        {
+            groupDownwards += hot.stages[slot].smoothGain;
+            groupUpwards += 1.0f;
+            downwardsRan = true;
+        }
+
+        return true;
+    };
+
+    // The chain's positions: the downwards and upwards stages in the order
+    // UPWARDS_FIRST picks, then STAGE3 and STAGE4. Each stage after the
+    // first is in series with the ones before it, or parallel to the
+    // previous one: a branch on the same input, detecting on the same
+    // signal, with the branches' outputs averaged. Stages switched off or
+    // bypassed are left out.
+    const bool upwardsFirst = param (ULTRADYN_PARAM_UPWARDS_FIRST) > 0.5f;
+    const int slots[maxStages] = { upwardsFirst ? 1 : 0, upwardsFirst ? 0 : 1, 2, 3 };
+    // (the first position has nothing to be parallel to; its entry is unused)
+    const ultradyn_param parallelParams[maxStages] = { ULTRADYN_PARAM_STAGE2_PARALLEL, ULTRADYN_PARAM_STAGE2_PARALLEL,
+                                                       ULTRADYN_PARAM_STAGE3_PARALLEL, ULTRADYN_PARAM_STAGE4_PARALLEL };
+
+    // First position: detector EQ on the input's mono sum
+    std::memcpy (scScratch.data(), monoScratch.data(), (size_t) numSamples * sizeof (float));
+    hot.scEQ[0].process (scScratch.data(), numSamples);
+
+    // The lowest quality tier lets every later position detect on the first
+    // one's sidechain
+    const bool sharedSidechain = hot.qualityTier >= 2;
+
+    const float* sidechain = scScratch.data();
+    int numGainCurves = 0, appliedToMono = 0, appliedToPeaks = 0;
+
+    // Every channel gets the same gains, so the average of the branches'
+    // outputs is the input times the mean of their gains: the group leaves
+    // one curve, in its first one's place
+    const auto closeGroup = [&]
+    {
+        const int numCurves = numGainCurves - groupStart;
+        if (groupBranches > 1 && numCurves > 0)
+        {
+            float* mean = gainScratch[groupStart].data();
+            for (int c = groupStart + 1; c < numGainCurves; ++c)
+            {
+                const float* branch = gainScratch[c].data();
+                for (int n = 0; n < numSamples; ++n)
+                    mean[n] += branch[n];
+            }
+
+            // Branches passing the signal through add a gain of 1 each
+            const float passThrough = (float) (groupBranches - numCurves);
+            const float scale = 1.0f / (float) groupBranches;
+            for (int n = 0; n < numSamples; ++n)
+                mean[n] = (mean[n] + passThrough) * scale;
+
+            numGainCurves = groupStart + 1;
+        }
+
+        if (groupBranches > 0)
+        {
+            downwardsGain *= groupDownwards / (float) groupBranches;
+            upwardsGain *= groupUpwards / (float) groupBranches;
+        }
+
+        groupStart = numGainCurves;
+        groupBranches = 0;
+        groupDownwards = groupUpwards = 0.0f;
+    };
+
+    for (int pos = 0; pos < maxStages; ++pos)
+    {
+        const int slot = slots[pos];
+        const auto type = getStageType (slot);
+        if (type == StageType::off
+            || (slot == 0 && param (ULTRADYN_PARAM_DOWNWARDS_BYPASS) > 0.5f)
+            || (slot == 1 && param (ULTRADYN_PARAM_UPWARDS_BYPASS) > 0.5f))
+        {
+            // Its detector EQ starts from silence when it comes back
+            if (pos > 0)
+                hot.scEQ[pos].reset();
+            continue;
+        }
+
+        // A new group unless it is parallel to a stage that runs
+        const bool parallel = groupBranches > 0 && param (parallelParams[pos]) > 0.5f;
+        if (! parallel)
+            closeGroup();
+
+        // In series: every channel gets the same gains, so the mono sum of the
+        // stages' output so far is the input's mono sum times their gains,
+        // and the position's own detector EQ needs no pass over the channels
+        if (pos > 0 && ! parallel && ! sharedSidechain)
+        {
+            for (; appliedToMono < groupStart; ++appliedToMono)
+                dsp->applyGainCurve (monoScratch.data(), gainScratch[appliedToMono].data(), numSamples, 1.0f);
+
+            std::memcpy (chainScratch.data(), monoScratch.data(), (size_t) numSamples * sizeof (float));
+            hot.scEQ[pos].process (chainScratch.data(), numSamples);
+            sidechain = chainScratch.data();
+        }
+        else if (pos > 0)
+        {
+            // Not using its own sidechain: its EQ starts from silence when it does again
+            hot.scEQ[pos].reset();
+        }
+
+        // A limiter detects on the loudest channel's sample peaks, which the
+        // same gains scale, even on the lowest quality tier: a shared
+        // sidechain would let the stages before it push peaks over its ceiling
+        const float* detectorInput = sidechain;
+        if (type == StageType::limiter)
+        {
+            for (; appliedToPeaks < groupStart; ++appliedToPeaks)
+                dsp->applyGainCurve (peakScratch.data(), gainScratch[appliedToPeaks].data(), numSamples, 1.0f);
+
+            detectorInput = peakScratch.data();
+        }
+
+        if (runStage (slot, type, detectorInput, gainScratch[numGainCurves].data()))
+            ++numGainCurves;
+    }
+
+    closeGroup();
+
+    if (upwardsHeld)
+        hot.upwardsStartupDelay += numSamples;
+
+    if (downwardsRan)
+        meters.grDb.store (std::min (60.0f, std::max (0.0f, -DSPTables::gainToDecibels (downwardsGain + 1.0e-9f))));
+    if (upwardsRan)
+        meters.upwardsGainDb.store (std::min (20.0f, std::max (0.0f, DSPTables::gainToDecibels (upwardsGain + 1.0e-9f))));
+
+    return numGainCurves;
+}
+
+int CompressorCore::processSpectral (float* const* channels, int numCh, int startSample, int numSamples) noexcept
+{
+    // The time constant glides advance as they would in the broadband stages
+    const auto stageFor = [this, numSamples] (StageDirection direction)
+    {
+        const bool upwards = direction == StageDirection::upwards;
+        auto& state = hot.stages[upwards ? 1 : 0];
+
+        SpectralCompressor::Stage stage;
+        stage.attackCoeff  = state.attackCoeff.advance (numSamples);
+        stage.releaseCoeff = state.releaseCoeff.advance (numSamples);
+
+        if (upwards)
+        {
+            stage.settings = StageSettings::make (param (ULTRADYN_PARAM_UPWARDS_THRESHOLD), param (ULTRADYN_PARAM_UPWARDS_RATIO),
+                                                  param (ULTRADYN_PARAM_UPWARDS_KNEE), param (ULTRADYN_PARAM_UPWARDS_MIX) * 0.01f,
+                                                  decibelsToGain (param (ULTRADYN_PARAM_UPWARDS_OUTPUT)));
+            stage.active = param (ULTRADYN_PARAM_UPWARDS_BYPASS) < 0.5f && hot.audioIsActive;
+        }
+        else
+        {
+            stage.settings = StageSettings::make (param (ULTRADYN_PARAM_THRESHOLD), param (ULTRADYN_PARAM_RATIO),
+                                                  param (ULTRADYN_PARAM_KNEE), param (ULTRADYN_PARAM_MIX) * 0.01f,
+                                                  decibelsToGain (param (ULTRADYN_PARAM_DOWNWARDS_OUTPUT)));
+            stage.active = param (ULTRADYN_PARAM_DOWNWARDS_BYPASS) < 0.5f;
+        }
+
+        return stage;
+    };
+
+    // The bins detect on the unfiltered input; that is what the analyzer shows
+    if (analyzerTap.isEnabled())
+        dsp->sumToMono (scScratch.data(), channels, numCh, startSample, numSamples);
+
+    spectral.process (channels, startSample, wetChannels.data(), numCh, numSamples,
+                      stageFor (StageDirection::downwards), stageFor (StageDirection::upwards));
+
+    meters.grDb.store (spectral.getGainReductionDb());
+    meters.upwardsGainDb.store (spectral.getUpwardsGainDb());
+    return 0;
+}
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "AnalyzerTap.h"
+#include "CompressorStage.h"
+#include "DSPKernels.h"
+#include "LevelHistogram.h"
+#include "LinkBus.h"
+#include "ScratchArena.h"
+#include "SharedTables.h"
+#include "SidechainEQ.h"
+#include "SpectralCompressor.h"
+#include "TruePeakLimiter.h"
+#include "UltraDynCore.h"
+#include "WorkerPool.h"
+
+namespace ultradyn
+{
+//==============================================================================
+// The compressor behind the C API in UltraDynCore.h. No JUCE, no allocation
+// outside prepare().
+class CompressorCore
+{
+public:
+    CompressorCore();
+
+    void prepare (double sampleRate, int numChannels);
+    void reset() noexcept;
+
+    // Thread-safe; coefficient caches are refreshed on the next sub-block
+    void setParameter (int index, float value) noexcept;
+    float getParameter (int index) const noexcept;
+
+    void process (float* const* channels, int numChannels, int numSamples) noexcept;
+
+    // Delay added by the true-peak limiter's lookahead plus the spectral
+    // mode's frame (1024 samples), each only while it is on
+    int getLatencySamples() const noexcept;
+
+    // Joins the group LINK_GROUP names, or leaves the current one. Not
+    // realtime safe; false if the group could not be joined.
+    bool updateLink();
+
+    // Starts the worker threads for CHANNEL_THREADS if it is on and the
+    // prepared channel count is wide enough; returns how many run. Not
+    // realtime safe. Once started they stay, parked while unused, until the
+    // next prepare().
+    int updateChannelThreads();
+
+    // Engine tier picked by AUTO_QUALITY (see ultradyn_quality_tier)
+    int getQualityTier() const noexcept { return meters.qualityTier.load (std::memory_order_relaxed); }
+
+    // Offline rendering: RENDER_PROFILE decides the engine (see
+    // ultradyn_set_non_realtime). Thread-safe; applies from the next process().
+    void setNonRealtime (bool isNonRealtime) noexcept { nonRealtime.store (isNonRealtime, std::memory_order_relaxed); }
+
+    // Detector level histograms, stage 0 downwards, 1 upwards (see
+    // ultradyn_get_histogram), and thresholds suggested from them
+    uint64_t readHistogram (int stage, uint32_t* counts) const noexcept { return histograms[stage].read (counts); }
+    void resetHistograms() noexcept;
+    float suggestThreshold (int stage, float percentOfTime) const noexcept;
+    float suggestThresholdForGain (int stage, float averageDb) const noexcept;
+
+    // Detector and output signals for a spectrum analyzer (see
+    // ultradyn_set_analyzer_enabled); one reader thread
+    void setAnalyzerEnabled (bool shouldBeEnabled) { analyzerTap.setEnabled (shouldBeEnabled); }
+    int readAnalyzer (float* detector, float* output, int maxSamples) noexcept { return analyzerTap.pull (detector, output, maxSamples); }
+
+    ultradyn_meters getMeters() const noexcept;
+    size_t getMemoryFootprintBytes() const noexcept;
+
+    // The scratch arena's share of that: every buffer the audio thread uses
+    size_t getScratchBytes() const noexcept { return scratch.getSizeInBytes(); }
+
+    // Parameter metadata in ultradyn_param order (nullptr past the end)
+    struct ParameterInfo
+    {
+        const char* id;
+        float minValue, maxValue, defaultValue;
+    };
+
+    static const ParameterInfo* getParameterInfo (int index) noexcept;
+
+    // Host blocks are processed in sub-blocks of at most this many samples:
+    // scratch stays in L1 and parameters update at a fixed control rate
+    static constexpr int maxSubBlockSize = 128;
+
+    // Channel threads: only from this many channels, one task per
+    // channelsPerTask of them (the calling thread takes one), and only for
+    // calls of at least a full sub-block
+    static constexpr int minParallelChannels = 16;
+    static constexpr int channelsPerTask = 8;
+    static constexpr int maxChannelWorkers = 3;
+
+    // Stage slots: downwards, upwards, STAGE3, STAGE4
+    static constexpr int maxStages = ULTRADYN_MAX_STAGES;
+    enum class StageType { off, downwards, upwards, limiter };
+
+private:
+    //==============================================================================
+    // Everything process() touches per sample, packed into as few cache lines
+    // as possible and kept apart from the UI-facing meter values
+    struct alignas (64) HotState
+    {
+        // Sidechain EQ for detector path (HPF, low shelf, peak, high shelf),
+        // one per chain position: [0] filters the input, the others the
+        // output of the stages before them
+        SidechainEQ scEQ[maxStages];
+
+        // Per stage slot: RMS detector (squared average), smoothed linear
+        // gain, attack/release coefficients and control-rate interval
+        StageState stages[maxStages];
+
+        // Control-rate gain computer: curve and smoothing run once per interval
+        bool controlRateGain = false;
+
+        int upwardsStartupDelay = 0;  // Delay counter to prevent immediate processing
+        int audioInactiveCounter = 0; // Counter for detecting when audio stops
+        bool audioIsActive = false;   // Track if audio is currently being processed
+
+        // Vocal mode and drumbus mode for sidechain EQ
+        bool vocalModeEnabled = false;
+        bool drumbusModeEnabled = false;
+
+        bool limiterEnabled = false;
+        bool spectralEnabled = false;
+
+        // Render profile in use for this process() call
+        bool rendering = false;
+
+        // Tasks each sub-block's channel work is split into for this
+        // process() call: 1, or the channel workers plus the caller
+        int numTasks = 1;
+
+        // Auto quality: share of the block duration spent in process(), low-pass
+        // filtered like juce::AudioProcessLoadMeasurer, and the samples left
+        // before the tier may step down again / of headroom seen so far
+        int qualityTier = 0;
+        float load = 0.0f;
+        int tierHoldSamples = 0;
+        int headroomSamples = 0;
+
+        // Detector link, fixed per process() call: the other members' loudest
+        // and summed downwards detector levels (mean square), and this
+        // instance's own peak level, published at the end of the call
+        bool linked = false;
+        bool linkSum = false;
+        float linkOthersLoudest = 0.0f;
+        float linkOthersSum = 0.0f;
+        float linkLevel = 0.0f;
+    };
+
+    // Written by the audio thread, polled by the editor; on its own cache line
+    // so editor reads never contend with the hot state
+    struct alignas (64) MeterState
+    {
+        std::atomic<float> grDb { 0.0f };          // positive dB reduction
+        std::atomic<float> upwardsGainDb { 0.0f }; // positive dB gain
+        std::atomic<float> inputLevel { -60.0f };
+        std::atomic<float> outputLevel { -60.0f };
+        std::atomic<int> qualityTier { 0 };
+    };
+
+    HotState hot;
+    MeterState meters;
+
+    static const int ACTIVATION_DELAY_SAMPLES = 441; // 10ms at 44.1kHz
+    static const int DEACTIVATION_THRESHOLD = 2205; // 50ms of silence to deactivate
+
+    std::atomic<float> params[ULTRADYN_NUM_PARAMS];
+
+    double sampleRate = 44100.0;
+
+    // Immutable lookup tables shared with every other instance at this sample rate
+    std::shared_ptr<const DSPTables> tables;
+
+    // Hot loops for the instruction set picked in prepare()
+    const kernels::Table* dsp = kernels::getScalarTable();
+
+    // Both stages per frequency bin, in place of the broadband ones
+    SpectralCompressor spectral;
+
+    // Final stage, after the output gain
+    TruePeakLimiter limiter;
+
+    // Group this instance's downwards detector is linked to
+    LinkMember link;
+
+    // Where the detectors' levels have been, per stage
+    LevelHistogram histograms[2];
+
+    // Copies of the detector and output signals while an analyzer reads them
+    AnalyzerTap analyzerTap;
+
+    // Every buffer the audio thread works in, carved out of one block in
+    // prepare(): the views below, the limiter's and the spectral mode's
+    ScratchArena scratch;
+
+    // Scratch, one sub-block long: unfiltered mono sum, the first and the
+    // later chain positions' filtered detector signals, detector envelope
+    // (mean square), the loudest channel's sample peak for limiter stages, the
+    // per-sample gains the stages apply, in order, and the wet signal per channel
+    ArenaView<float> monoScratch, scScratch, chainScratch, envScratch, peakScratch;
+    ArenaView<float> gainScratch[maxStages];
+    ArenaView<float*> wetChannels;
+    ArenaView<float> wetStorage;
+
+    // Splits the per-channel work of wide buses with the calling thread
+    WorkerPool channelWorkers;
+
+    // Per task: the input or output peak of its share, and the limiter's
+    // detector peaks over its channels (one sub-block each)
+    float taskLevels[maxChannelWorkers + 1] {};
+    ArenaView<float> taskLimiterPeaks;
+
+    // Set by setParameter; coefficients are only recomputed when dirty
+    std::atomic<bool> timeConstantsDirty { true };
+    std::atomic<bool> sidechainEQDirty { true };
+
+    // Set by the host while bouncing
+    std::atomic<bool> nonRealtime { false };
+
+    inline float param (ultradyn_param p) const noexcept { return params[p].load (std::memory_order_relaxed); }
+
+    void updateSidechainEQ (int rampSamples) noexcept;
+    void updateTimeConstants (int rampSamples) noexcept;
+    void updateQualityTier (double processSeconds, int numSamples) noexcept;
+    void setQualityTier (int tier) noexcept;
+    void processSubBlock (float* const* channels, int numCh, int startSample, int numSamples,
+                          float& inputPeak, float& outputPeak) noexcept;
+
+    // Runs job (task) for tasks 0 .. hot.numTasks - 1, on the channel
+    // workers when there is more than one
+    template <typename Job>
+    void forEachTask (Job&& job) noexcept;
+
+    void runUpwardsDetector (StageState& state, const float* scData, float* env, int numSamples) noexcept;
+
+    // What a slot runs: the first two are fixed, STAGE3/4_TYPE picks the others
+    StageType getStageType (int slot) const noexcept;
+
+    // The stages: broadband, the whole chain computing the gain curves for
+    // the wet channels into gainScratch and returning how many there are, or
+    // the downwards and upwards stages per bin in spectral mode, which
+    // processes the wet copy itself (and delays the dry signal to match) and
+    // returns 0
+    int processBroadband (int numSamples) noexcept;
+    int processSpectral (float* const* channels, int numCh, int startSample, int numSamples) noexcept;
+
+    // Run a slot's detector and gain computer over the sidechain and write
+    // the gain it applies to gains (stage mix and output gain included),
+    // per sample or at control rate depending on CONTROL_RATE
+    void computeStageGains (int slot, StageType type, const float* scData, float* gains, int numSamples, float stageGain) noexcept;
+
+    CompressorCore (const CompressorCore&) = delete;
+    CompressorCore& operator= (const CompressorCore&) = delete;
+};
+}
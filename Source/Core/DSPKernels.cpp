@@ -0,0 +1,230 @@
+#include "DSPKernels.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "BatchKernel.h"
+#include "TruePeakKernel.h"
+#include "SpectralKernel.h"
+
+#if ULTRADYN_KERNELS_X86
+ #if defined (_MSC_VER)
+  #include <intrin.h>
+ #else
+  #include <cpuid.h>
+ #endif
+#endif
+
+namespace ultradyn
+{
+namespace kernels
+{
+namespace
+{
+    //==============================================================================
+    // Reference implementations, also the fallback on unknown targets
+    void applyGainCurveScalar (float* data, const float* gains, int numSamples, float mix) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            data[i] *= (1.0f - mix) + gains[i] * mix;
+    }
+
+    void applyGainRampScalar (float* data, int numSamples, float startGain, float step, float mix) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            data[i] *= (1.0f - mix) + (startGain + step * (float) (i + 1)) * mix;
+    }
+
+    void mixDryWetScalar (float* out, const float* dry, const float* wet, int numSamples, float mix) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            out[i] = dry[i] * (1.0f - mix) + wet[i] * mix;
+    }
+
+    void sumToMonoScalar (float* dst, const float* const* channels, int numChannels, int offset, int numSamples) noexcept
+    {
+        const float scale = 1.0f / (float) (numChannels > 0 ? numChannels : 1);
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float s = 0.0f;
+            for (int ch = 0; ch < numChannels; ++ch)
+                s += channels[ch][offset + i];
+            dst[i] = s * scale;
+        }
+    }
+
+    float peakAbsScalar (const float* data, int numSamples) noexcept
+    {
+        float peak = 0.0f;
+        for (int i = 0; i < numSamples; ++i)
+            peak = std::fmax (peak, std::fabs (data[i]));
+        return peak;
+    }
+
+    void rmsEnvelopeScalar (const float* x, float* env, int numSamples, float coeff, float& state) noexcept
+    {
+        float s = state;
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float x2 = x[i] * x[i];
+            s = std::fmax (1.0e-12f, x2 + (s - x2) * coeff);
+            env[i] = s;
+        }
+        state = s;
+    }
+
+    const Table scalarTable { ISA::scalar, "scalar",
+                              applyGainCurveScalar, applyGainRampScalar, mixDryWetScalar,
+                              sumToMonoScalar, peakAbsScalar, rmsEnvelopeScalar,
+                              cascade::process<cascade::ScalarOps>,
+                              batch::compress<batch::ScalarVec>, batch::ScalarVec::width,
+                              truepeak::detect<batch::ScalarVec>,
+                              spectral::binGains<batch::ScalarVec> };
+
+    //==============================================================================
+   #if ULTRADYN_KERNELS_X86
+    void cpuid (unsigned leaf, unsigned subleaf, unsigned regs[4]) noexcept
+    {
+       #if defined (_MSC_VER)
+        int r[4];
+        __cpuidex (r, (int) leaf, (int) subleaf);
+        for (int i = 0; i < 4; ++i)
+            regs[i] = (unsigned) r[i];
+       #else
+        if (! __get_cpuid_count (leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3]))
+            regs[0] = regs[1] = regs[2] = regs[3] = 0;
+       #endif
+    }
+
+    // Register state the OS saves on context switch (XCR0)
+    uint64_t readXCR0() noexcept
+    {
+       #if defined (_MSC_VER)
+        return _xgetbv (0);
+       #else
+        uint32_t lo, hi;
+        __asm__ volatile ("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+        return ((uint64_t) hi << 32) | lo;
+       #endif
+    }
+   #endif
+
+    ISA detect() noexcept
+    {
+       #if ULTRADYN_KERNELS_X86
+        unsigned r1[4], r7[4];
+        cpuid (0, 0, r1);
+        const unsigned maxLeaf = r1[0];
+
+        cpuid (1, 0, r1);
+        if ((r1[3] & (1u << 26)) == 0)
+            return ISA::scalar;
+
+        const bool osxsave = (r1[2] & (1u << 27)) != 0;
+        const bool fma     = (r1[2] & (1u << 12)) != 0;
+        const uint64_t xcr0 = osxsave ? readXCR0() : 0;
+        const bool osAVX    = (xcr0 & 0x6) == 0x6;    // XMM + YMM
+        const bool osAVX512 = (xcr0 & 0xe6) == 0xe6;  // + opmask, ZMM
+
+        if (maxLeaf >= 7)
+        {
+            cpuid (7, 0, r7);
+            const bool avx2    = (r7[1] & (1u << 5)) != 0;
+            const bool avx512f = (r7[1] & (1u << 16)) != 0;
+
+            if (avx512f && avx2 && fma && osAVX512 && getAVX512Table() != nullptr) return ISA::avx512;
+            if (avx2 && fma && osAVX && getAVX2Table() != nullptr)                return ISA::avx2;
+        }
+        return getSSE2Table() != nullptr ? ISA::sse2 : ISA::scalar;
+       #else
+        return getNEONTable() != nullptr ? ISA::neon : ISA::scalar;
+       #endif
+    }
+
+    std::atomic<int> overrideISA { (int) ISA::best };
+
+    int rank (ISA isa) noexcept
+    {
+        switch (isa)
+        {
+            case ISA::scalar: return 0;
+            case ISA::sse2:
+            case ISA::neon:   return 1;
+            case ISA::avx2:   return 2;
+            case ISA::avx512: return 3;
+            case ISA::best:   break;
+        }
+        return 4;
+    }
+}
+
+//==============================================================================
+const Table* getScalarTable() noexcept { return &scalarTable; }
+
+ISA detectBestISA() noexcept
+{
+    static const ISA best = detect();
+    return best;
+}
+
+const Table* getTable (ISA isa) noexcept
+{
+    if (isa == ISA::best)
+        isa = detectBestISA();
+
+    if (rank (isa) > rank (detectBestISA()))
+        return nullptr;
+
+    switch (isa)
+    {
+        case ISA::scalar: return getScalarTable();
+        case ISA::sse2:   return getSSE2Table();
+        case ISA::avx2:   return getAVX2Table();
+        case ISA::avx512: return getAVX512Table();
+        case ISA::neon:   return getNEONTable();
+        case ISA::best:   break;
+    }
+    return nullptr;
+}
+
+const Table& select() noexcept
+{
+    auto requested = (ISA) overrideISA.load (std::memory_order_relaxed);
+
+    if (requested == ISA::best)
+        if (const char* env = std::getenv ("ULTRADYN_ISA"))
+            requested = parseISA (env);
+
+    // Step down until a level is available
+    static const ISA fallbackOrder[] = { ISA::avx512, ISA::avx2, ISA::sse2, ISA::neon, ISA::scalar };
+    if (const auto* table = getTable (requested))
+        return *table;
+
+    for (auto isa : fallbackOrder)
+        if (rank (isa) <= rank (requested))
+            if (const auto* table = getTable (isa))
+                return *table;
+
+    return scalarTable;
+}
+
+void setOverride (ISA isa) noexcept
+{
+    overrideISA.store ((int) isa, std::memory_order_relaxed);
+}
+
+ISA parseISA (const char* name) noexcept
+{
+    if (name == nullptr)                   return ISA::best;
+    if (std::strcmp (name, "scalar") == 0) return ISA::scalar;
+    if (std::strcmp (name, "sse2") == 0)   return ISA::sse2;
+    if (std::strcmp (name, "avx2") == 0)   return ISA::avx2;
+    if (std::strcmp (name, "avx512") == 0) return ISA::avx512;
+    if (std::strcmp (name, "neon") == 0)   return ISA::neon;
+    return ISA::best;
+}
+}
+}
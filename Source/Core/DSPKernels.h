@@ -0,0 +1,115 @@
+#pragma once
+
+#include "SidechainEQ.h"
+
+// x86 levels build on the SSE2 baseline; ARM builds use NEON
+#if ULTRADYN_SIDECHAIN_SSE2
+ #define ULTRADYN_KERNELS_X86 1
+ #include <xmmintrin.h>
+#elif ULTRADYN_SIDECHAIN_NEON
+ #define ULTRADYN_KERNELS_NEON 1
+#endif
+
+namespace ultradyn
+{
+namespace kernels
+{
+//==============================================================================
+// Hot per-sample loops, compiled once per instruction-set level and picked at
+// run time from the features of the CPU we are running on.
+//
+// Every level computes the same thing; only the rounding of the detector scan
+// differs (about 1e-5 relative). Call select() from prepareToPlay and keep the
+// returned table; it lives for the whole process.
+enum class ISA { scalar, sse2, avx2, avx512, neon, best };
+
+struct Table
+{
+    ISA isa;
+    const char* name;
+
+    // data[i] *= (1 - mix) + gains[i] * mix
+    void (*applyGainCurve) (float* data, const float* gains, int numSamples, float mix) noexcept;
+
+    // data[i] *= (1 - mix) + g * mix, with g stepping from startGain + step by step
+    void (*applyGainRamp) (float* data, int numSamples, float startGain, float step, float mix) noexcept;
+
+    // out[i] = dry[i] * (1 - mix) + wet[i] * mix; out may alias dry
+    void (*mixDryWet) (float* out, const float* dry, const float* wet, int numSamples, float mix) noexcept;
+
+    // dst[i] = mean of channels[ch][offset + i]
+    void (*sumToMono) (float* dst, const float* const* channels, int numChannels, int offset, int numSamples) noexcept;
+
+    // max |data[i]|
+    float (*peakAbs) (const float* data, int numSamples) noexcept;
+
+    // Mean-square detector: state = coeff * state + (1 - coeff) * x[i]^2, floored
+    // at 1e-12, written to env[i]; state carries over between calls
+    void (*rmsEnvelope) (const float* x, float* env, int numSamples, float coeff, float& state) noexcept;
+
+    // Four-stage sidechain EQ cascade
+    BiquadCascadeFn biquadCascade;
+
+    // Multi-stream compressor: frames[numSamples][numLanes] in place, one lane
+    // per stream, settings and state in rows (see BatchKernel.h). numLanes is a
+    // multiple of batch::maxWidth; batchWidth streams advance per instruction.
+    void (*compressBatch) (float* rows, int numLanes, float* frames, int numSamples) noexcept;
+    int batchWidth;
+
+    // Inter-sample peak detector for the output limiter: peak[i] = max (peak[i],
+    // 4x true peak at history[i + 5]), reading history[0 .. numSamples + 10]
+    // (see TruePeakKernel.h)
+    void (*truePeak) (const float* history, float* peak, int numSamples) noexcept;
+
+    // Spectral mode, one frame: gains of both stages per bin from the bins'
+    // mean square, numBins a multiple of 16 (see SpectralKernel.h)
+    void (*spectralGains) (const float* settings, const float* power, float* downGains, float* upGains,
+                           float* gains, int numBins) noexcept;
+};
+
+//==============================================================================
+// Flush denormals to zero for the duration of a process call, like
+// juce::ScopedNoDenormals (C API callers may not have set the FP mode)
+struct ScopedFlushDenormals
+{
+   #if ULTRADYN_KERNELS_X86
+    ScopedFlushDenormals() noexcept : saved (_mm_getcsr()) { _mm_setcsr (saved | 0x8040); } // FTZ | DAZ
+    ~ScopedFlushDenormals() noexcept { _mm_setcsr (saved); }
+    unsigned int saved;
+   #elif ULTRADYN_KERNELS_NEON && defined (__aarch64__)
+    ScopedFlushDenormals() noexcept
+    {
+        asm volatile ("mrs %0, fpcr" : "=r" (saved));
+        asm volatile ("msr fpcr, %0" : : "r" (saved | (1ull << 24))); // FZ
+    }
+    ~ScopedFlushDenormals() noexcept { asm volatile ("msr fpcr, %0" : : "r" (saved)); }
+    unsigned long long saved;
+   #endif
+};
+
+// Best level this CPU and OS support
+ISA detectBestISA() noexcept;
+
+// Table for a level, or nullptr if it is not compiled in or not supported here
+const Table* getTable (ISA isa) noexcept;
+
+// Table to use: the forced level if one is set, else ULTRADYN_ISA from the
+// environment (scalar, sse2, avx2, avx512, neon), else the best supported.
+// An unsupported request falls back to the best level below it.
+const Table& select() noexcept;
+
+// Forces a level for testing; ISA::best clears the override
+void setOverride (ISA isa) noexcept;
+
+// "scalar", "sse2", ... -> ISA (ISA::best if unknown)
+ISA parseISA (const char* name) noexcept;
+
+//==============================================================================
+// Per-level tables (nullptr where the level is not compiled for this target)
+const Table* getScalarTable() noexcept;
+const Table* getSSE2Table() noexcept;
+const Table* getAVX2Table() noexcept;
+const Table* getAVX512Table() noexcept;
+const Table* getNEONTable() noexcept;
+}
+}
@@ -0,0 +1,325 @@
+#include "DSPKernels.h"
+
+#if ULTRADYN_KERNELS_X86
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+
+// The kernels are compiled for AVX2 + FMA and only ever called after
+// detectBestISA() has confirmed both. System headers and the table getter stay
+// outside the target switch so nothing shared is built with it; the batch
+// kernel template is included inside it to be instantiated for this level.
+#if defined (__clang__)
+ #pragma clang attribute push (__attribute__ ((target ("avx2,fma"))), apply_to = function)
+#elif defined (__GNUC__)
+ #pragma GCC push_options
+ #pragma GCC target ("avx2,fma")
+#endif
+
+#include "BatchKernel.h"
+#include "TruePeakKernel.h"
+#include "SpectralKernel.h"
+
+namespace ultradyn
+{
+namespace kernels
+{
+namespace
+{
+    inline float horizontalMax (__m256 v) noexcept
+    {
+        __m128 m = _mm_max_ps (_mm256_castps256_ps128 (v), _mm256_extractf128_ps (v, 1));
+        m = _mm_max_ps (m, _mm_shuffle_ps (m, m, _MM_SHUFFLE (1, 0, 3, 2)));
+        m = _mm_max_ps (m, _mm_shuffle_ps (m, m, _MM_SHUFFLE (2, 3, 0, 1)));
+        return _mm_cvtss_f32 (m);
+    }
+
+    // Lane k receives lane k - n, low lanes are zeroed
+    template <int n>
+    inline __m256 shiftUp (__m256 v) noexcept
+    {
+        const __m256i idx = _mm256_setr_epi32 (0 - n, 1 - n, 2 - n, 3 - n, 4 - n, 5 - n, 6 - n, 7 - n);
+        const __m256 moved = _mm256_permutevar8x32_ps (v, _mm256_max_epi32 (idx, _mm256_setzero_si256()));
+        return _mm256_blend_ps (moved, _mm256_setzero_ps(), (1 << n) - 1);
+    }
+
+    void applyGainCurveAVX2 (float* data, const float* gains, int numSamples, float mix) noexcept
+    {
+        const __m256 dry = _mm256_set1_ps (1.0f - mix), vmix = _mm256_set1_ps (mix);
+        int i = 0;
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            const __m256 g = _mm256_fmadd_ps (_mm256_loadu_ps (gains + i), vmix, dry);
+            _mm256_storeu_ps (data + i, _mm256_mul_ps (_mm256_loadu_ps (data + i), g));
+        }
+        for (; i < numSamples; ++i)
+            data[i] *= (1.0f - mix) + gains[i] * mix;
+    }
+
+    void applyGainRampAVX2 (float* data, int numSamples, float startGain, float step, float mix) noexcept
+    {
+        const __m256 dry = _mm256_set1_ps (1.0f - mix), vmix = _mm256_set1_ps (mix);
+        const __m256 vstep = _mm256_set1_ps (8.0f * step);
+        __m256 g = _mm256_fmadd_ps (_mm256_set1_ps (step), _mm256_setr_ps (1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f),
+                                    _mm256_set1_ps (startGain));
+        int i = 0;
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            _mm256_storeu_ps (data + i, _mm256_mul_ps (_mm256_loadu_ps (data + i), _mm256_fmadd_ps (g, vmix, dry)));
+            g = _mm256_add_ps (g, vstep);
+        }
+        for (; i < numSamples; ++i)
+            data[i] *= (1.0f - mix) + (startGain + step * (float) (i + 1)) * mix;
+    }
+
+    void mixDryWetAVX2 (float* out, const float* dry, const float* wet, int numSamples, float mix) noexcept
+    {
+        const __m256 vdry = _mm256_set1_ps (1.0f - mix), vwet = _mm256_set1_ps (mix);
+        int i = 0;
+        for (; i + 8 <= numSamples; i += 8)
+            _mm256_storeu_ps (out + i, _mm256_fmadd_ps (_mm256_loadu_ps (wet + i), vwet,
+                                                        _mm256_mul_ps (_mm256_loadu_ps (dry + i), vdry)));
+        for (; i < numSamples; ++i)
+            out[i] = dry[i] * (1.0f - mix) + wet[i] * mix;
+    }
+
+    void sumToMonoAVX2 (float* dst, const float* const* channels, int numChannels, int offset, int numSamples) noexcept
+    {
+        const float scale = 1.0f / (float) (numChannels > 0 ? numChannels : 1);
+        const __m256 vscale = _mm256_set1_ps (scale);
+        int i = 0;
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            __m256 s = _mm256_setzero_ps();
+            for (int ch = 0; ch < numChannels; ++ch)
+                s = _mm256_add_ps (s, _mm256_loadu_ps (channels[ch] + offset + i));
+            _mm256_storeu_ps (dst + i, _mm256_mul_ps (s, vscale));
+        }
+        for (; i < numSamples; ++i)
+        {
+            float s = 0.0f;
+            for (int ch = 0; ch < numChannels; ++ch)
+                s += channels[ch][offset + i];
+            dst[i] = s * scale;
+        }
+    }
+
+    float peakAbsAVX2 (const float* data, int numSamples) noexcept
+    {
+        const __m256 absMask = _mm256_castsi256_ps (_mm256_set1_epi32 (0x7fffffff));
+        __m256 peak0 = _mm256_setzero_ps(), peak1 = _mm256_setzero_ps();
+        int i = 0;
+        for (; i + 16 <= numSamples; i += 16)
+        {
+            peak0 = _mm256_max_ps (peak0, _mm256_and_ps (_mm256_loadu_ps (data + i), absMask));
+            peak1 = _mm256_max_ps (peak1, _mm256_and_ps (_mm256_loadu_ps (data + i + 8), absMask));
+        }
+
+        float result = horizontalMax (_mm256_max_ps (peak0, peak1));
+        for (; i < numSamples; ++i)
+            result = std::fmax (result, std::fabs (data[i]));
+        return result;
+    }
+
+    // Eight-lane version of the block prefix scan in DSPKernels_SSE2.cpp:
+    // the serial path is one multiply-add and a max per 32 samples
+    void rmsEnvelopeAVX2 (const float* x, float* env, int numSamples, float coeff, float& state) noexcept
+    {
+        float p[8];
+        p[0] = coeff;
+        for (int k = 1; k < 8; ++k)
+            p[k] = p[k - 1] * coeff;
+
+        const __m256 gainIn = _mm256_set1_ps (1.0f - coeff);
+        const __m256 vc1 = _mm256_set1_ps (p[0]), vc2 = _mm256_set1_ps (p[1]), vc4 = _mm256_set1_ps (p[3]);
+        const __m256 step = _mm256_set1_ps (p[7]);
+        __m256 powers[4] = { _mm256_loadu_ps (p) };
+        for (int j = 1; j < 4; ++j)
+            powers[j] = _mm256_mul_ps (powers[j - 1], step);
+        const __m256 floor = _mm256_set1_ps (1.0e-12f);
+        const __m256i last = _mm256_set1_epi32 (7);
+
+        const auto localScan = [&] (const float* in8)
+        {
+            const __m256 in = _mm256_loadu_ps (in8);
+            __m256 u = _mm256_mul_ps (gainIn, _mm256_mul_ps (in, in));
+            u = _mm256_fmadd_ps (vc1, shiftUp<1> (u), u);
+            u = _mm256_fmadd_ps (vc2, shiftUp<2> (u), u);
+            return _mm256_fmadd_ps (vc4, shiftUp<4> (u), u);
+        };
+        const auto lastLane = [last] (__m256 v) { return _mm256_permutevar8x32_ps (v, last); };
+
+        __m256 carry = _mm256_set1_ps (state);
+        int i = 0;
+        for (; i + 32 <= numSamples; i += 32)
+        {
+            __m256 u[4];
+            for (int j = 0; j < 4; ++j)
+                u[j] = localScan (x + i + 8 * j);
+            for (int j = 1; j < 4; ++j)
+                u[j] = _mm256_fmadd_ps (powers[0], lastLane (u[j - 1]), u[j]);
+
+            __m256 y;
+            for (int j = 0; j < 4; ++j)
+            {
+                y = _mm256_max_ps (floor, _mm256_fmadd_ps (powers[j], carry, u[j]));
+                _mm256_storeu_ps (env + i + 8 * j, y);
+            }
+            carry = lastLane (y);
+        }
+
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            const __m256 y = _mm256_max_ps (floor, _mm256_fmadd_ps (powers[0], carry, localScan (x + i)));
+            _mm256_storeu_ps (env + i, y);
+            carry = lastLane (y);
+        }
+
+        float s = _mm256_cvtss_f32 (carry);
+        for (; i < numSamples; ++i)
+        {
+            const float x2 = x[i] * x[i];
+            s = std::fmax (1.0e-12f, x2 + (s - x2) * coeff);
+            env[i] = s;
+        }
+        state = s;
+    }
+
+    // The cascade is four stages wide whatever the register width, so this is
+    // the SSE2 loop with fused multiply-adds, which shortens the per-sample
+    // dependency chain from six operations to three
+    template <bool ramping>
+    void runCascadeFMA (BiquadCascadeState& s, float* data, int start, int end) noexcept
+    {
+        __m128 vb0 = _mm_load_ps (s.b0), vb1 = _mm_load_ps (s.b1), vb2 = _mm_load_ps (s.b2);
+        __m128 va1 = _mm_load_ps (s.a1), va2 = _mm_load_ps (s.a2);
+        __m128 vz1 = _mm_load_ps (s.z1), vz2 = _mm_load_ps (s.z2), vy = _mm_load_ps (s.out);
+
+        __m128 vdb0 {}, vdb1 {}, vdb2 {}, vda1 {}, vda2 {};
+        if (ramping)
+        {
+            vdb0 = _mm_load_ps (s.db0); vdb1 = _mm_load_ps (s.db1); vdb2 = _mm_load_ps (s.db2);
+            vda1 = _mm_load_ps (s.da1); vda2 = _mm_load_ps (s.da2);
+        }
+
+        for (int n = start; n < end; ++n)
+        {
+            if (ramping)
+            {
+                vb0 = _mm_add_ps (vb0, vdb0); vb1 = _mm_add_ps (vb1, vdb1); vb2 = _mm_add_ps (vb2, vdb2);
+                va1 = _mm_add_ps (va1, vda1); va2 = _mm_add_ps (va2, vda2);
+            }
+
+            // { x, y0, y1, y2 }: each stage takes the previous output of the one before
+            const __m128 shifted = _mm_castsi128_ps (_mm_slli_si128 (_mm_castps_si128 (vy), 4));
+            const __m128 x = _mm_move_ss (shifted, _mm_set_ss (data[n]));
+
+            vy  = _mm_fmadd_ps (vb0, x, vz1);
+            vz1 = _mm_fnmadd_ps (va1, vy, _mm_fmadd_ps (vb1, x, vz2));
+            vz2 = _mm_fnmadd_ps (va2, vy, _mm_mul_ps (vb2, x));
+
+            data[n] = _mm_cvtss_f32 (_mm_shuffle_ps (vy, vy, _MM_SHUFFLE (3, 3, 3, 3)));
+        }
+
+        _mm_store_ps (s.z1, vz1); _mm_store_ps (s.z2, vz2); _mm_store_ps (s.out, vy);
+
+        if (ramping)
+        {
+            _mm_store_ps (s.b0, vb0); _mm_store_ps (s.b1, vb1); _mm_store_ps (s.b2, vb2);
+            _mm_store_ps (s.a1, va1); _mm_store_ps (s.a2, va2);
+        }
+    }
+
+    void biquadCascadeFMA (BiquadCascadeState& s, float* data, int start, int end, bool ramping) noexcept
+    {
+        if (ramping) runCascadeFMA<true>  (s, data, start, end);
+        else         runCascadeFMA<false> (s, data, start, end);
+    }
+
+    //==============================================================================
+    // Eight streams per register for the batch compressor
+    struct AVX2Vec
+    {
+        using Reg = __m256;
+        using Mask = __m256;
+        static constexpr int width = 8;
+
+        static inline Reg load (const float* p) noexcept           { return _mm256_load_ps (p); }
+        static inline void store (float* p, Reg v) noexcept        { _mm256_store_ps (p, v); }
+        static inline Reg loadu (const float* p) noexcept          { return _mm256_loadu_ps (p); }
+        static inline void storeu (float* p, Reg v) noexcept       { _mm256_storeu_ps (p, v); }
+        static inline Reg set (float v) noexcept                   { return _mm256_set1_ps (v); }
+        static inline Reg add (Reg a, Reg b) noexcept              { return _mm256_add_ps (a, b); }
+        static inline Reg sub (Reg a, Reg b) noexcept              { return _mm256_sub_ps (a, b); }
+        static inline Reg mul (Reg a, Reg b) noexcept              { return _mm256_mul_ps (a, b); }
+        static inline Reg madd (Reg a, Reg b, Reg c) noexcept      { return _mm256_fmadd_ps (a, b, c); }
+        static inline Reg div1 (Reg a) noexcept                    { return _mm256_div_ps (_mm256_set1_ps (1.0f), a); }
+        static inline Reg min (Reg a, Reg b) noexcept              { return _mm256_min_ps (a, b); }
+        static inline Reg max (Reg a, Reg b) noexcept              { return _mm256_max_ps (a, b); }
+        static inline Mask lt (Reg a, Reg b) noexcept              { return _mm256_cmp_ps (a, b, _CMP_LT_OQ); }
+        static inline Mask gt (Reg a, Reg b) noexcept              { return _mm256_cmp_ps (a, b, _CMP_GT_OQ); }
+        static inline Reg select (Mask m, Reg a, Reg b) noexcept   { return _mm256_blendv_ps (b, a, m); }
+        static inline Reg floor (Reg x) noexcept                   { return _mm256_floor_ps (x); }
+
+        static inline Reg exponent (Reg x) noexcept
+        {
+            const __m256i e = _mm256_srli_epi32 (_mm256_castps_si256 (x), 23);
+            return _mm256_cvtepi32_ps (_mm256_sub_epi32 (e, _mm256_set1_epi32 (127)));
+        }
+
+        static inline Reg mantissa (Reg x) noexcept
+        {
+            const __m256i bits = _mm256_and_si256 (_mm256_castps_si256 (x), _mm256_set1_epi32 (0x007fffff));
+            return _mm256_castsi256_ps (_mm256_or_si256 (bits, _mm256_set1_epi32 (0x3f800000)));
+        }
+
+        static inline Reg pow2 (Reg n) noexcept
+        {
+            const __m256i e = _mm256_add_epi32 (_mm256_cvttps_epi32 (n), _mm256_set1_epi32 (127));
+            return _mm256_castsi256_ps (_mm256_slli_epi32 (e, 23));
+        }
+    };
+
+    void compressBatchAVX2 (float* rows, int numLanes, float* frames, int numSamples) noexcept
+    {
+        batch::compress<AVX2Vec> (rows, numLanes, frames, numSamples);
+    }
+
+    void truePeakAVX2 (const float* history, float* peak, int numSamples) noexcept
+    {
+        truepeak::detect<AVX2Vec> (history, peak, numSamples);
+    }
+
+    void spectralGainsAVX2 (const float* settings, const float* power, float* downGains, float* upGains,
+                            float* gains, int numBins) noexcept
+    {
+        spectral::binGains<AVX2Vec> (settings, power, downGains, upGains, gains, numBins);
+    }
+}
+
+#if defined (__clang__)
+ #pragma clang attribute pop
+#elif defined (__GNUC__)
+ #pragma GCC pop_options
+#endif
+
+namespace
+{
+    const Table avx2Table { ISA::avx2, "avx2",
+                            applyGainCurveAVX2, applyGainRampAVX2, mixDryWetAVX2,
+                            sumToMonoAVX2, peakAbsAVX2, rmsEnvelopeAVX2,
+                            biquadCascadeFMA, compressBatchAVX2, AVX2Vec::width,
+                            truePeakAVX2, spectralGainsAVX2 };
+}
+
+const Table* getAVX2Table() noexcept { return &avx2Table; }
+}
+}
+
+#else
+
+namespace ultradyn { namespace kernels { const Table* getAVX2Table() noexcept { return nullptr; } } }
+
+#endif
@@ -0,0 +1,272 @@
+#include "DSPKernels.h"
+
+#if ULTRADYN_KERNELS_X86
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// GCC flags the _mm512_undefined_* placeholders inside the masked and
+// reducing intrinsics as uninitialised; they are never read
+#if defined (__GNUC__) && ! defined (__clang__)
+ #pragma GCC diagnostic push
+ #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+ #pragma GCC diagnostic ignored "-Wuninitialized"
+#endif
+
+#include <immintrin.h>
+
+// Compiled for AVX-512F; see DSPKernels_AVX2.cpp for why the target switch
+// only covers the kernels themselves
+#if defined (__clang__)
+ #pragma clang attribute push (__attribute__ ((target ("avx512f,avx2,fma"))), apply_to = function)
+#elif defined (__GNUC__)
+ #pragma GCC push_options
+ #pragma GCC target ("avx512f,avx2,fma")
+#endif
+
+#include "BatchKernel.h"
+#include "TruePeakKernel.h"
+#include "SpectralKernel.h"
+
+namespace ultradyn
+{
+namespace kernels
+{
+namespace
+{
+    // Mask covering the first numSamples lanes (numSamples < 16)
+    inline __mmask16 tailMask (int numSamples) noexcept
+    {
+        return (__mmask16) ((1u << numSamples) - 1u);
+    }
+
+    // Lane k receives lane k - n, low lanes are zeroed
+    template <int n>
+    inline __m512 shiftUp (__m512 v) noexcept
+    {
+        const __m512i lanes = _mm512_setr_epi32 (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        const __m512i idx = _mm512_max_epi32 (_mm512_sub_epi32 (lanes, _mm512_set1_epi32 (n)), _mm512_setzero_si512());
+        return _mm512_maskz_permutexvar_ps ((__mmask16) (0xffffu << n), idx, v);
+    }
+
+    // Tails use masked loads and stores instead of a scalar loop
+    void applyGainCurveAVX512 (float* data, const float* gains, int numSamples, float mix) noexcept
+    {
+        const __m512 dry = _mm512_set1_ps (1.0f - mix), vmix = _mm512_set1_ps (mix);
+        int i = 0;
+        for (; i + 16 <= numSamples; i += 16)
+        {
+            const __m512 g = _mm512_fmadd_ps (_mm512_loadu_ps (gains + i), vmix, dry);
+            _mm512_storeu_ps (data + i, _mm512_mul_ps (_mm512_loadu_ps (data + i), g));
+        }
+        if (i < numSamples)
+        {
+            const __mmask16 m = tailMask (numSamples - i);
+            const __m512 g = _mm512_fmadd_ps (_mm512_maskz_loadu_ps (m, gains + i), vmix, dry);
+            _mm512_mask_storeu_ps (data + i, m, _mm512_mul_ps (_mm512_maskz_loadu_ps (m, data + i), g));
+        }
+    }
+
+    void applyGainRampAVX512 (float* data, int numSamples, float startGain, float step, float mix) noexcept
+    {
+        const __m512 dry = _mm512_set1_ps (1.0f - mix), vmix = _mm512_set1_ps (mix);
+        const __m512 vstep = _mm512_set1_ps (16.0f * step);
+        const __m512 ramp = _mm512_setr_ps (1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f,
+                                            9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f);
+        __m512 g = _mm512_fmadd_ps (_mm512_set1_ps (step), ramp, _mm512_set1_ps (startGain));
+        int i = 0;
+        for (; i + 16 <= numSamples; i += 16)
+        {
+            _mm512_storeu_ps (data + i, _mm512_mul_ps (_mm512_loadu_ps (data + i), _mm512_fmadd_ps (g, vmix, dry)));
+            g = _mm512_add_ps (g, vstep);
+        }
+        if (i < numSamples)
+        {
+            const __mmask16 m = tailMask (numSamples - i);
+            _mm512_mask_storeu_ps (data + i, m, _mm512_mul_ps (_mm512_maskz_loadu_ps (m, data + i), _mm512_fmadd_ps (g, vmix, dry)));
+        }
+    }
+
+    void mixDryWetAVX512 (float* out, const float* dry, const float* wet, int numSamples, float mix) noexcept
+    {
+        const __m512 vdry = _mm512_set1_ps (1.0f - mix), vwet = _mm512_set1_ps (mix);
+        int i = 0;
+        for (; i + 16 <= numSamples; i += 16)
+            _mm512_storeu_ps (out + i, _mm512_fmadd_ps (_mm512_loadu_ps (wet + i), vwet,
+                                                        _mm512_mul_ps (_mm512_loadu_ps (dry + i), vdry)));
+        if (i < numSamples)
+        {
+            const __mmask16 m = tailMask (numSamples - i);
+            _mm512_mask_storeu_ps (out + i, m, _mm512_fmadd_ps (_mm512_maskz_loadu_ps (m, wet + i), vwet,
+                                                               _mm512_mul_ps (_mm512_maskz_loadu_ps (m, dry + i), vdry)));
+        }
+    }
+
+    void sumToMonoAVX512 (float* dst, const float* const* channels, int numChannels, int offset, int numSamples) noexcept
+    {
+        const __m512 vscale = _mm512_set1_ps (1.0f / (float) (numChannels > 0 ? numChannels : 1));
+        for (int i = 0; i < numSamples; i += 16)
+        {
+            const __mmask16 m = numSamples - i >= 16 ? (__mmask16) 0xffff : tailMask (numSamples - i);
+            __m512 s = _mm512_setzero_ps();
+            for (int ch = 0; ch < numChannels; ++ch)
+                s = _mm512_add_ps (s, _mm512_maskz_loadu_ps (m, channels[ch] + offset + i));
+            _mm512_mask_storeu_ps (dst + i, m, _mm512_mul_ps (s, vscale));
+        }
+    }
+
+    float peakAbsAVX512 (const float* data, int numSamples) noexcept
+    {
+        __m512 peak0 = _mm512_setzero_ps(), peak1 = _mm512_setzero_ps();
+        int i = 0;
+        for (; i + 32 <= numSamples; i += 32)
+        {
+            peak0 = _mm512_max_ps (peak0, _mm512_abs_ps (_mm512_loadu_ps (data + i)));
+            peak1 = _mm512_max_ps (peak1, _mm512_abs_ps (_mm512_loadu_ps (data + i + 16)));
+        }
+        for (; i < numSamples; i += 16)
+        {
+            const __mmask16 m = numSamples - i >= 16 ? (__mmask16) 0xffff : tailMask (numSamples - i);
+            peak0 = _mm512_max_ps (peak0, _mm512_abs_ps (_mm512_maskz_loadu_ps (m, data + i)));
+        }
+        return _mm512_reduce_max_ps (_mm512_max_ps (peak0, peak1));
+    }
+
+    // Sixteen-lane version of the block prefix scan in DSPKernels_SSE2.cpp,
+    // in blocks of two vectors: at this width the fix-up between four would
+    // cost more latency than it saves at the core's 128-sample sub-blocks
+    void rmsEnvelopeAVX512 (const float* x, float* env, int numSamples, float coeff, float& state) noexcept
+    {
+        float p[16];
+        p[0] = coeff;
+        for (int k = 1; k < 16; ++k)
+            p[k] = p[k - 1] * coeff;
+
+        const __m512 gainIn = _mm512_set1_ps (1.0f - coeff);
+        const __m512 vc1 = _mm512_set1_ps (p[0]), vc2 = _mm512_set1_ps (p[1]);
+        const __m512 vc4 = _mm512_set1_ps (p[3]), vc8 = _mm512_set1_ps (p[7]);
+        const __m512 step = _mm512_set1_ps (p[15]);
+        const __m512 powers[2] = { _mm512_loadu_ps (p), _mm512_mul_ps (_mm512_loadu_ps (p), step) };
+        const __m512 floor = _mm512_set1_ps (1.0e-12f);
+        const __m512i last = _mm512_set1_epi32 (15);
+
+        const auto localScan = [&] (const float* in16)
+        {
+            const __m512 in = _mm512_loadu_ps (in16);
+            __m512 u = _mm512_mul_ps (gainIn, _mm512_mul_ps (in, in));
+            u = _mm512_fmadd_ps (vc1, shiftUp<1> (u), u);
+            u = _mm512_fmadd_ps (vc2, shiftUp<2> (u), u);
+            u = _mm512_fmadd_ps (vc4, shiftUp<4> (u), u);
+            return _mm512_fmadd_ps (vc8, shiftUp<8> (u), u);
+        };
+        const auto lastLane = [last] (__m512 v) { return _mm512_permutexvar_ps (last, v); };
+
+        __m512 carry = _mm512_set1_ps (state);
+        int i = 0;
+        for (; i + 32 <= numSamples; i += 32)
+        {
+            const __m512 u0 = localScan (x + i);
+            const __m512 u1 = _mm512_fmadd_ps (powers[0], lastLane (u0), localScan (x + i + 16));
+
+            _mm512_storeu_ps (env + i, _mm512_max_ps (floor, _mm512_fmadd_ps (powers[0], carry, u0)));
+            const __m512 y = _mm512_max_ps (floor, _mm512_fmadd_ps (powers[1], carry, u1));
+            _mm512_storeu_ps (env + i + 16, y);
+            carry = lastLane (y);
+        }
+
+        for (; i + 16 <= numSamples; i += 16)
+        {
+            const __m512 y = _mm512_max_ps (floor, _mm512_fmadd_ps (powers[0], carry, localScan (x + i)));
+            _mm512_storeu_ps (env + i, y);
+            carry = lastLane (y);
+        }
+
+        float s = _mm512_cvtss_f32 (carry);
+        for (; i < numSamples; ++i)
+        {
+            const float x2 = x[i] * x[i];
+            s = std::fmax (1.0e-12f, x2 + (s - x2) * coeff);
+            env[i] = s;
+        }
+        state = s;
+    }
+
+    //==============================================================================
+    // Sixteen streams per register for the batch compressor
+    struct AVX512Vec
+    {
+        using Reg = __m512;
+        using Mask = __mmask16;
+        static constexpr int width = 16;
+
+        static inline Reg load (const float* p) noexcept           { return _mm512_load_ps (p); }
+        static inline void store (float* p, Reg v) noexcept        { _mm512_store_ps (p, v); }
+        static inline Reg loadu (const float* p) noexcept          { return _mm512_loadu_ps (p); }
+        static inline void storeu (float* p, Reg v) noexcept       { _mm512_storeu_ps (p, v); }
+        static inline Reg set (float v) noexcept                   { return _mm512_set1_ps (v); }
+        static inline Reg add (Reg a, Reg b) noexcept              { return _mm512_add_ps (a, b); }
+        static inline Reg sub (Reg a, Reg b) noexcept              { return _mm512_sub_ps (a, b); }
+        static inline Reg mul (Reg a, Reg b) noexcept              { return _mm512_mul_ps (a, b); }
+        static inline Reg madd (Reg a, Reg b, Reg c) noexcept      { return _mm512_fmadd_ps (a, b, c); }
+        static inline Reg div1 (Reg a) noexcept                    { return _mm512_div_ps (_mm512_set1_ps (1.0f), a); }
+        static inline Reg min (Reg a, Reg b) noexcept              { return _mm512_min_ps (a, b); }
+        static inline Reg max (Reg a, Reg b) noexcept              { return _mm512_max_ps (a, b); }
+        static inline Mask lt (Reg a, Reg b) noexcept              { return _mm512_cmp_ps_mask (a, b, _CMP_LT_OQ); }
+        static inline Mask gt (Reg a, Reg b) noexcept              { return _mm512_cmp_ps_mask (a, b, _CMP_GT_OQ); }
+        static inline Reg select (Mask m, Reg a, Reg b) noexcept   { return _mm512_mask_blend_ps (m, b, a); }
+        static inline Reg floor (Reg x) noexcept                   { return _mm512_roundscale_ps (x, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+
+        // getexp/getmant split a float exactly as the scalar bit twiddling does
+        static inline Reg exponent (Reg x) noexcept                { return _mm512_getexp_ps (x); }
+        static inline Reg mantissa (Reg x) noexcept                { return _mm512_getmant_ps (x, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_zero); }
+        static inline Reg pow2 (Reg n) noexcept                    { return _mm512_scalef_ps (_mm512_set1_ps (1.0f), n); }
+    };
+
+    void compressBatchAVX512 (float* rows, int numLanes, float* frames, int numSamples) noexcept
+    {
+        batch::compress<AVX512Vec> (rows, numLanes, frames, numSamples);
+    }
+
+    void truePeakAVX512 (const float* history, float* peak, int numSamples) noexcept
+    {
+        truepeak::detect<AVX512Vec> (history, peak, numSamples);
+    }
+
+    void spectralGainsAVX512 (const float* settings, const float* power, float* downGains, float* upGains,
+                              float* gains, int numBins) noexcept
+    {
+        spectral::binGains<AVX512Vec> (settings, power, downGains, upGains, gains, numBins);
+    }
+}
+
+#if defined (__clang__)
+ #pragma clang attribute pop
+#elif defined (__GNUC__)
+ #pragma GCC pop_options
+#endif
+
+// The four-stage cascade cannot use more than four lanes; it shares the FMA
+// kernel of the AVX2 level
+const Table* getAVX512Table() noexcept
+{
+    static const Table avx512Table { ISA::avx512, "avx512",
+                                     applyGainCurveAVX512, applyGainRampAVX512, mixDryWetAVX512,
+                                     sumToMonoAVX512, peakAbsAVX512, rmsEnvelopeAVX512,
+                                     getAVX2Table()->biquadCascade,
+                                     compressBatchAVX512, AVX512Vec::width,
+                                     truePeakAVX512, spectralGainsAVX512 };
+    return &avx512Table;
+}
+}
+}
+
+#if defined (__GNUC__) && ! defined (__clang__)
+ #pragma GCC diagnostic pop
+#endif
+
+#else
+
+namespace ultradyn { namespace kernels { const Table* getAVX512Table() noexcept { return nullptr; } } }
+
+#endif
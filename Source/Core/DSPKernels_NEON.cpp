@@ -0,0 +1,204 @@
+#include "DSPKernels.h"
+
+#if ULTRADYN_KERNELS_NEON
+
+#include <cmath>
+#include <arm_neon.h>
+
+#include "BatchKernel.h"
+#include "TruePeakKernel.h"
+#include "SpectralKernel.h"
+
+namespace ultradyn
+{
+namespace kernels
+{
+namespace
+{
+    inline float horizontalMax (float32x4_t v) noexcept
+    {
+        const float32x2_t m = vpmax_f32 (vget_low_f32 (v), vget_high_f32 (v));
+        return vget_lane_f32 (vpmax_f32 (m, m), 0);
+    }
+
+    void applyGainCurveNEON (float* data, const float* gains, int numSamples, float mix) noexcept
+    {
+        const float32x4_t dry = vdupq_n_f32 (1.0f - mix);
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const float32x4_t g = vmlaq_n_f32 (dry, vld1q_f32 (gains + i), mix);
+            vst1q_f32 (data + i, vmulq_f32 (vld1q_f32 (data + i), g));
+        }
+        for (; i < numSamples; ++i)
+            data[i] *= (1.0f - mix) + gains[i] * mix;
+    }
+
+    void applyGainRampNEON (float* data, int numSamples, float startGain, float step, float mix) noexcept
+    {
+        const float32x4_t dry = vdupq_n_f32 (1.0f - mix);
+        const float32x4_t vstep = vdupq_n_f32 (4.0f * step);
+        const float ramp[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+        float32x4_t g = vmlaq_n_f32 (vdupq_n_f32 (startGain), vld1q_f32 (ramp), step);
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            vst1q_f32 (data + i, vmulq_f32 (vld1q_f32 (data + i), vmlaq_n_f32 (dry, g, mix)));
+            g = vaddq_f32 (g, vstep);
+        }
+        for (; i < numSamples; ++i)
+            data[i] *= (1.0f - mix) + (startGain + step * (float) (i + 1)) * mix;
+    }
+
+    void mixDryWetNEON (float* out, const float* dry, const float* wet, int numSamples, float mix) noexcept
+    {
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4)
+            vst1q_f32 (out + i, vmlaq_n_f32 (vmulq_n_f32 (vld1q_f32 (dry + i), 1.0f - mix), vld1q_f32 (wet + i), mix));
+        for (; i < numSamples; ++i)
+            out[i] = dry[i] * (1.0f - mix) + wet[i] * mix;
+    }
+
+    void sumToMonoNEON (float* dst, const float* const* channels, int numChannels, int offset, int numSamples) noexcept
+    {
+        const float scale = 1.0f / (float) (numChannels > 0 ? numChannels : 1);
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            float32x4_t s = vdupq_n_f32 (0.0f);
+            for (int ch = 0; ch < numChannels; ++ch)
+                s = vaddq_f32 (s, vld1q_f32 (channels[ch] + offset + i));
+            vst1q_f32 (dst + i, vmulq_n_f32 (s, scale));
+        }
+        for (; i < numSamples; ++i)
+        {
+            float s = 0.0f;
+            for (int ch = 0; ch < numChannels; ++ch)
+                s += channels[ch][offset + i];
+            dst[i] = s * scale;
+        }
+    }
+
+    float peakAbsNEON (const float* data, int numSamples) noexcept
+    {
+        float32x4_t peak = vdupq_n_f32 (0.0f);
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4)
+            peak = vmaxq_f32 (peak, vabsq_f32 (vld1q_f32 (data + i)));
+
+        float result = horizontalMax (peak);
+        for (; i < numSamples; ++i)
+            result = std::fmax (result, std::fabs (data[i]));
+        return result;
+    }
+
+    // Four-lane prefix scan, as in DSPKernels_SSE2.cpp
+    void rmsEnvelopeNEON (const float* x, float* env, int numSamples, float coeff, float& state) noexcept
+    {
+        const float c2 = coeff * coeff;
+        const float p[4] = { coeff, c2, c2 * coeff, c2 * c2 };
+        const float32x4_t powers = vld1q_f32 (p);
+        const float32x4_t floor = vdupq_n_f32 (1.0e-12f);
+        const float32x4_t zero = vdupq_n_f32 (0.0f);
+
+        float32x4_t carry = vdupq_n_f32 (state);
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const float32x4_t in = vld1q_f32 (x + i);
+            float32x4_t u = vmulq_n_f32 (vmulq_f32 (in, in), 1.0f - coeff);
+            u = vmlaq_n_f32 (u, vextq_f32 (zero, u, 3), coeff);
+            u = vmlaq_n_f32 (u, vextq_f32 (zero, u, 2), c2);
+
+            const float32x4_t y = vmaxq_f32 (floor, vmlaq_f32 (u, powers, carry));
+            vst1q_f32 (env + i, y);
+            carry = vdupq_lane_f32 (vget_high_f32 (y), 1);
+        }
+
+        float s = vgetq_lane_f32 (carry, 0);
+        for (; i < numSamples; ++i)
+        {
+            const float x2 = x[i] * x[i];
+            s = std::fmax (1.0e-12f, x2 + (s - x2) * coeff);
+            env[i] = s;
+        }
+        state = s;
+    }
+
+    //==============================================================================
+    // Four streams per register for the batch compressor
+    struct NeonVec
+    {
+        using Reg = float32x4_t;
+        using Mask = uint32x4_t;
+        static constexpr int width = 4;
+
+        static inline Reg load (const float* p) noexcept           { return vld1q_f32 (p); }
+        static inline void store (float* p, Reg v) noexcept        { vst1q_f32 (p, v); }
+        static inline Reg loadu (const float* p) noexcept          { return vld1q_f32 (p); }
+        static inline void storeu (float* p, Reg v) noexcept       { vst1q_f32 (p, v); }
+        static inline Reg set (float v) noexcept                   { return vdupq_n_f32 (v); }
+        static inline Reg add (Reg a, Reg b) noexcept              { return vaddq_f32 (a, b); }
+        static inline Reg sub (Reg a, Reg b) noexcept              { return vsubq_f32 (a, b); }
+        static inline Reg mul (Reg a, Reg b) noexcept              { return vmulq_f32 (a, b); }
+        static inline Reg madd (Reg a, Reg b, Reg c) noexcept      { return vmlaq_f32 (c, a, b); }
+        static inline Reg min (Reg a, Reg b) noexcept              { return vminq_f32 (a, b); }
+        static inline Reg max (Reg a, Reg b) noexcept              { return vmaxq_f32 (a, b); }
+        static inline Mask lt (Reg a, Reg b) noexcept              { return vcltq_f32 (a, b); }
+        static inline Mask gt (Reg a, Reg b) noexcept              { return vcgtq_f32 (a, b); }
+        static inline Reg select (Mask m, Reg a, Reg b) noexcept   { return vbslq_f32 (m, a, b); }
+
+        static inline Reg div1 (Reg a) noexcept
+        {
+           #if defined (__aarch64__)
+            return vdivq_f32 (vdupq_n_f32 (1.0f), a);
+           #else
+            Reg r = vrecpeq_f32 (a); // two Newton steps to full precision
+            r = vmulq_f32 (r, vrecpsq_f32 (a, r));
+            return vmulq_f32 (r, vrecpsq_f32 (a, r));
+           #endif
+        }
+
+        static inline Reg floor (Reg x) noexcept
+        {
+            const Reg t = vcvtq_f32_s32 (vcvtq_s32_f32 (x));
+            return vsubq_f32 (t, vreinterpretq_f32_u32 (vandq_u32 (vcgtq_f32 (t, x), vreinterpretq_u32_f32 (vdupq_n_f32 (1.0f)))));
+        }
+
+        static inline Reg exponent (Reg x) noexcept
+        {
+            const int32x4_t e = vreinterpretq_s32_u32 (vshrq_n_u32 (vreinterpretq_u32_f32 (x), 23));
+            return vcvtq_f32_s32 (vsubq_s32 (e, vdupq_n_s32 (127)));
+        }
+
+        static inline Reg mantissa (Reg x) noexcept
+        {
+            const uint32x4_t bits = vandq_u32 (vreinterpretq_u32_f32 (x), vdupq_n_u32 (0x007fffffu));
+            return vreinterpretq_f32_u32 (vorrq_u32 (bits, vdupq_n_u32 (0x3f800000u)));
+        }
+
+        static inline Reg pow2 (Reg n) noexcept
+        {
+            const int32x4_t e = vaddq_s32 (vcvtq_s32_f32 (n), vdupq_n_s32 (127));
+            return vreinterpretq_f32_s32 (vshlq_n_s32 (e, 23));
+        }
+    };
+
+    const Table neonTable { ISA::neon, "neon",
+                            applyGainCurveNEON, applyGainRampNEON, mixDryWetNEON,
+                            sumToMonoNEON, peakAbsNEON, rmsEnvelopeNEON,
+                            cascade::process<cascade::NeonOps>,
+                            batch::compress<NeonVec>, NeonVec::width,
+                            truepeak::detect<NeonVec>,
+                            spectral::binGains<NeonVec> };
+}
+
+const Table* getNEONTable() noexcept { return &neonTable; }
+}
+}
+
+#else
+
+namespace ultradyn { namespace kernels { const Table* getNEONTable() noexcept { return nullptr; } } }
+
+#endif
@@ -0,0 +1,239 @@
+#include "DSPKernels.h"
+
+#if ULTRADYN_KERNELS_X86
+
+#include <cmath>
+#include <emmintrin.h>
+
+#include "BatchKernel.h"
+#include "TruePeakKernel.h"
+#include "SpectralKernel.h"
+
+namespace ultradyn
+{
+namespace kernels
+{
+namespace
+{
+    inline float horizontalMax (__m128 v) noexcept
+    {
+        v = _mm_max_ps (v, _mm_shuffle_ps (v, v, _MM_SHUFFLE (1, 0, 3, 2)));
+        v = _mm_max_ps (v, _mm_shuffle_ps (v, v, _MM_SHUFFLE (2, 3, 0, 1)));
+        return _mm_cvtss_f32 (v);
+    }
+
+    // Lane k receives lane k - n, low lanes are zeroed
+    template <int n>
+    inline __m128 shiftUp (__m128 v) noexcept
+    {
+        return _mm_castsi128_ps (_mm_slli_si128 (_mm_castps_si128 (v), 4 * n));
+    }
+
+    void applyGainCurveSSE2 (float* data, const float* gains, int numSamples, float mix) noexcept
+    {
+        const __m128 dry = _mm_set1_ps (1.0f - mix), vmix = _mm_set1_ps (mix);
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const __m128 g = _mm_add_ps (dry, _mm_mul_ps (_mm_loadu_ps (gains + i), vmix));
+            _mm_storeu_ps (data + i, _mm_mul_ps (_mm_loadu_ps (data + i), g));
+        }
+        for (; i < numSamples; ++i)
+            data[i] *= (1.0f - mix) + gains[i] * mix;
+    }
+
+    void applyGainRampSSE2 (float* data, int numSamples, float startGain, float step, float mix) noexcept
+    {
+        const __m128 dry = _mm_set1_ps (1.0f - mix), vmix = _mm_set1_ps (mix);
+        const __m128 vstep = _mm_set1_ps (4.0f * step);
+        __m128 g = _mm_add_ps (_mm_set1_ps (startGain), _mm_mul_ps (_mm_set1_ps (step), _mm_setr_ps (1.0f, 2.0f, 3.0f, 4.0f)));
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            _mm_storeu_ps (data + i, _mm_mul_ps (_mm_loadu_ps (data + i), _mm_add_ps (dry, _mm_mul_ps (g, vmix))));
+            g = _mm_add_ps (g, vstep);
+        }
+        for (; i < numSamples; ++i)
+            data[i] *= (1.0f - mix) + (startGain + step * (float) (i + 1)) * mix;
+    }
+
+    void mixDryWetSSE2 (float* out, const float* dry, const float* wet, int numSamples, float mix) noexcept
+    {
+        const __m128 vdry = _mm_set1_ps (1.0f - mix), vwet = _mm_set1_ps (mix);
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4)
+            _mm_storeu_ps (out + i, _mm_add_ps (_mm_mul_ps (_mm_loadu_ps (dry + i), vdry),
+                                                _mm_mul_ps (_mm_loadu_ps (wet + i), vwet)));
+        for (; i < numSamples; ++i)
+            out[i] = dry[i] * (1.0f - mix) + wet[i] * mix;
+    }
+
+    void sumToMonoSSE2 (float* dst, const float* const* channels, int numChannels, int offset, int numSamples) noexcept
+    {
+        const float scale = 1.0f / (float) (numChannels > 0 ? numChannels : 1);
+        const __m128 vscale = _mm_set1_ps (scale);
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            __m128 s = _mm_setzero_ps();
+            for (int ch = 0; ch < numChannels; ++ch)
+                s = _mm_add_ps (s, _mm_loadu_ps (channels[ch] + offset + i));
+            _mm_storeu_ps (dst + i, _mm_mul_ps (s, vscale));
+        }
+        for (; i < numSamples; ++i)
+        {
+            float s = 0.0f;
+            for (int ch = 0; ch < numChannels; ++ch)
+                s += channels[ch][offset + i];
+            dst[i] = s * scale;
+        }
+    }
+
+    float peakAbsSSE2 (const float* data, int numSamples) noexcept
+    {
+        const __m128 absMask = _mm_castsi128_ps (_mm_set1_epi32 (0x7fffffff));
+        __m128 peak = _mm_setzero_ps();
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4)
+            peak = _mm_max_ps (peak, _mm_and_ps (_mm_loadu_ps (data + i), absMask));
+
+        float result = horizontalMax (peak);
+        for (; i < numSamples; ++i)
+            result = std::fmax (result, std::fabs (data[i]));
+        return result;
+    }
+
+    // The one-pole recurrence as a prefix scan, in blocks of four vectors.
+    // Inside a vector, two shifted multiply-adds resolve the dependencies;
+    // across the block, each vector adds the previous one's last lane times
+    // powers of the coefficient. None of that depends on the state, so blocks
+    // overlap freely: the state enters each block once, through powers 1..16,
+    // leaving one multiply-add and a max per 16 samples on the serial path.
+    void rmsEnvelopeSSE2 (const float* x, float* env, int numSamples, float coeff, float& state) noexcept
+    {
+        float p[4];
+        p[0] = coeff;
+        for (int k = 1; k < 4; ++k)
+            p[k] = p[k - 1] * coeff;
+
+        const __m128 gainIn = _mm_set1_ps (1.0f - coeff);
+        const __m128 vc = _mm_set1_ps (p[0]), vc2 = _mm_set1_ps (p[1]);
+        const __m128 step = _mm_set1_ps (p[3]);
+        __m128 powers[4] = { _mm_loadu_ps (p) };
+        for (int j = 1; j < 4; ++j)
+            powers[j] = _mm_mul_ps (powers[j - 1], step);
+        const __m128 floor = _mm_set1_ps (1.0e-12f);
+
+        const auto localScan = [&] (const float* in4)
+        {
+            const __m128 in = _mm_loadu_ps (in4);
+            __m128 u = _mm_mul_ps (gainIn, _mm_mul_ps (in, in));
+            u = _mm_add_ps (u, _mm_mul_ps (vc,  shiftUp<1> (u)));
+            return _mm_add_ps (u, _mm_mul_ps (vc2, shiftUp<2> (u)));
+        };
+        const auto lastLane = [] (__m128 v) { return _mm_shuffle_ps (v, v, _MM_SHUFFLE (3, 3, 3, 3)); };
+
+        __m128 carry = _mm_set1_ps (state);
+        int i = 0;
+        for (; i + 16 <= numSamples; i += 16)
+        {
+            __m128 u[4];
+            for (int j = 0; j < 4; ++j)
+                u[j] = localScan (x + i + 4 * j);
+            for (int j = 1; j < 4; ++j)
+                u[j] = _mm_add_ps (u[j], _mm_mul_ps (powers[0], lastLane (u[j - 1])));
+
+            __m128 y;
+            for (int j = 0; j < 4; ++j)
+            {
+                y = _mm_max_ps (floor, _mm_add_ps (u[j], _mm_mul_ps (powers[j], carry)));
+                _mm_storeu_ps (env + i + 4 * j, y);
+            }
+            carry = lastLane (y);
+        }
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const __m128 y = _mm_max_ps (floor, _mm_add_ps (localScan (x + i), _mm_mul_ps (powers[0], carry)));
+            _mm_storeu_ps (env + i, y);
+            carry = lastLane (y);
+        }
+
+        float s = _mm_cvtss_f32 (carry);
+        for (; i < numSamples; ++i)
+        {
+            const float x2 = x[i] * x[i];
+            s = std::fmax (1.0e-12f, x2 + (s - x2) * coeff);
+            env[i] = s;
+        }
+        state = s;
+    }
+
+    //==============================================================================
+    // Four streams per register for the batch compressor
+    struct SSE2Vec
+    {
+        using Reg = __m128;
+        using Mask = __m128;
+        static constexpr int width = 4;
+
+        static inline Reg load (const float* p) noexcept           { return _mm_load_ps (p); }
+        static inline void store (float* p, Reg v) noexcept        { _mm_store_ps (p, v); }
+        static inline Reg loadu (const float* p) noexcept          { return _mm_loadu_ps (p); }
+        static inline void storeu (float* p, Reg v) noexcept       { _mm_storeu_ps (p, v); }
+        static inline Reg set (float v) noexcept                   { return _mm_set1_ps (v); }
+        static inline Reg add (Reg a, Reg b) noexcept              { return _mm_add_ps (a, b); }
+        static inline Reg sub (Reg a, Reg b) noexcept              { return _mm_sub_ps (a, b); }
+        static inline Reg mul (Reg a, Reg b) noexcept              { return _mm_mul_ps (a, b); }
+        static inline Reg madd (Reg a, Reg b, Reg c) noexcept      { return _mm_add_ps (_mm_mul_ps (a, b), c); }
+        static inline Reg div1 (Reg a) noexcept                    { return _mm_div_ps (_mm_set1_ps (1.0f), a); }
+        static inline Reg min (Reg a, Reg b) noexcept              { return _mm_min_ps (a, b); }
+        static inline Reg max (Reg a, Reg b) noexcept              { return _mm_max_ps (a, b); }
+        static inline Mask lt (Reg a, Reg b) noexcept              { return _mm_cmplt_ps (a, b); }
+        static inline Mask gt (Reg a, Reg b) noexcept              { return _mm_cmpgt_ps (a, b); }
+        static inline Reg select (Mask m, Reg a, Reg b) noexcept   { return _mm_or_ps (_mm_and_ps (m, a), _mm_andnot_ps (m, b)); }
+
+        // No roundps before SSE4.1: truncate, then step down where that rounded up
+        static inline Reg floor (Reg x) noexcept
+        {
+            const __m128 t = _mm_cvtepi32_ps (_mm_cvttps_epi32 (x));
+            return _mm_sub_ps (t, _mm_and_ps (_mm_cmpgt_ps (t, x), _mm_set1_ps (1.0f)));
+        }
+
+        static inline Reg exponent (Reg x) noexcept
+        {
+            const __m128i e = _mm_srli_epi32 (_mm_castps_si128 (x), 23);
+            return _mm_cvtepi32_ps (_mm_sub_epi32 (e, _mm_set1_epi32 (127)));
+        }
+
+        static inline Reg mantissa (Reg x) noexcept
+        {
+            const __m128i bits = _mm_and_si128 (_mm_castps_si128 (x), _mm_set1_epi32 (0x007fffff));
+            return _mm_castsi128_ps (_mm_or_si128 (bits, _mm_set1_epi32 (0x3f800000)));
+        }
+
+        static inline Reg pow2 (Reg n) noexcept
+        {
+            const __m128i e = _mm_add_epi32 (_mm_cvttps_epi32 (n), _mm_set1_epi32 (127));
+            return _mm_castsi128_ps (_mm_slli_epi32 (e, 23));
+        }
+    };
+
+    const Table sse2Table { ISA::sse2, "sse2",
+                            applyGainCurveSSE2, applyGainRampSSE2, mixDryWetSSE2,
+                            sumToMonoSSE2, peakAbsSSE2, rmsEnvelopeSSE2,
+                            cascade::process<cascade::SSE2Ops>,
+                            batch::compress<SSE2Vec>, SSE2Vec::width,
+                            truepeak::detect<SSE2Vec>,
+                            spectral::binGains<SSE2Vec> };
+}
+
+const Table* getSSE2Table() noexcept { return &sse2Table; }
+}
+}
+
+#else
+
+namespace ultradyn { namespace kernels { const Table* getSSE2Table() noexcept { return nullptr; } } }
+
+#endif
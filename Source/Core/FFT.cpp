@@ -0,0 +1,167 @@
+#include "FFT.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ultradyn
+{
+//==============================================================================
+void RealFFT::prepare (int newSize)
+{
+    size = std::max (4, newSize);
+    half = size / 2;
+
+    twiddleRe.clear();
+    twiddleIm.clear();
+    for (int l = half / 2; l >= 1; l /= 2)
+    {
+        for (int j = 0; j < l; ++j)
+        {
+            const double angle = -M_PI * (double) j / (double) l;
+            twiddleRe.push_back ((float) std::cos (angle));
+            twiddleIm.push_back ((float) std::sin (angle));
+        }
+    }
+
+    splitRe.resize ((size_t) half + 1);
+    splitIm.resize ((size_t) half + 1);
+    for (int k = 0; k <= half; ++k)
+    {
+        const double angle = -2.0 * M_PI * (double) k / (double) size;
+        splitRe[(size_t) k] = (float) std::cos (angle);
+        splitIm[(size_t) k] = (float) std::sin (angle);
+    }
+
+    for (int b = 0; b < 2; ++b)
+    {
+        workRe[b].assign ((size_t) half, 0.0f);
+        workIm[b].assign ((size_t) half, 0.0f);
+    }
+}
+
+//==============================================================================
+// Stockham radix-2, decimation in frequency: pass p combines x[j m + k] and
+// x[j m + k + l m] into y[2 j m + k] and y[2 j m + m + k], with l halving and
+// m doubling each pass. The first pass (m = 1) runs along j in one loop.
+int RealFFT::transform (bool inverse) noexcept
+{
+    const float sign = inverse ? -1.0f : 1.0f;
+    int src = 0;
+    const float* wRe = twiddleRe.data();
+    const float* wIm = twiddleIm.data();
+
+    for (int l = half / 2, m = 1; l >= 1; l /= 2, m *= 2)
+    {
+        const float* xr = workRe[src].data();
+        const float* xi = workIm[src].data();
+        float* yr = workRe[1 - src].data();
+        float* yi = workIm[1 - src].data();
+
+        if (m == 1)
+        {
+            for (int j = 0; j < l; ++j)
+            {
+                const float ar = xr[j], ai = xi[j], br = xr[j + l], bi = xi[j + l];
+                const float dr = ar - br, di = ai - bi;
+                const float wr = wRe[j], wi = sign * wIm[j];
+                yr[2 * j] = ar + br;
+                yi[2 * j] = ai + bi;
+                yr[2 * j + 1] = dr * wr - di * wi;
+                yi[2 * j + 1] = dr * wi + di * wr;
+            }
+        }
+        else
+        {
+            for (int j = 0; j < l; ++j)
+            {
+                const float wr = wRe[j], wi = sign * wIm[j];
+                const float* ar = xr + j * m;
+                const float* ai = xi + j * m;
+                const float* br = ar + l * m;
+                const float* bi = ai + l * m;
+                float* sr = yr + 2 * j * m;
+                float* si = yi + 2 * j * m;
+                float* dr = sr + m;
+                float* di = si + m;
+
+                for (int k = 0; k < m; ++k)
+                {
+                    const float tr = ar[k] - br[k], ti = ai[k] - bi[k];
+                    sr[k] = ar[k] + br[k];
+                    si[k] = ai[k] + bi[k];
+                    dr[k] = tr * wr - ti * wi;
+                    di[k] = tr * wi + ti * wr;
+                }
+            }
+        }
+
+        wRe += l;
+        wIm += l;
+        src = 1 - src;
+    }
+
+    return src;
+}
+
+//==============================================================================
+// z[n] = x[2n] + i x[2n + 1] transforms to Z; with Zc[k] = conj (Z[half - k]),
+// X[k] = (Z[k] + Zc[k]) / 2 - i e^(-2 pi i k / size) (Z[k] - Zc[k]) / 2
+void RealFFT::forward (const float* time, float* re, float* im) noexcept
+{
+    for (int n = 0; n < half; ++n)
+    {
+        workRe[0][(size_t) n] = time[2 * n];
+        workIm[0][(size_t) n] = time[2 * n + 1];
+    }
+
+    const int out = transform (false);
+    const float* zr = workRe[out].data();
+    const float* zi = workIm[out].data();
+
+    re[0] = zr[0] + zi[0];
+    im[0] = 0.0f;
+    re[half] = zr[0] - zi[0];
+    im[half] = 0.0f;
+
+    for (int k = 1; k < half; ++k)
+    {
+        const float ar = zr[k], ai = zi[k];
+        const float cr = zr[half - k], ci = -zi[half - k];
+        const float er = 0.5f * (ar + cr), ei = 0.5f * (ai + ci);
+        const float or_ = 0.5f * (ai - ci), oi = -0.5f * (ar - cr);
+        const float wr = splitRe[(size_t) k], wi = splitIm[(size_t) k];
+        re[k] = er + or_ * wr - oi * wi;
+        im[k] = ei + or_ * wi + oi * wr;
+    }
+}
+
+// Z[k] = (X[k] + Xc[k]) + i e^(2 pi i k / size) (X[k] - Xc[k]), Xc[k] = conj (X[half - k]);
+// the half-size inverse of Z then holds size * (x[2n] + i x[2n + 1])
+void RealFFT::inverse (const float* re, const float* im, float* time) noexcept
+{
+    float* zr = workRe[0].data();
+    float* zi = workIm[0].data();
+
+    for (int k = 0; k < half; ++k)
+    {
+        const float ar = re[k], ai = im[k];
+        const float cr = re[half - k], ci = -im[half - k];
+        const float sr = ar + cr, si = ai + ci;
+        const float dr = ar - cr, di = ai - ci;
+        const float wr = splitRe[(size_t) k], wi = -splitIm[(size_t) k];
+        const float tr = dr * wr - di * wi, ti = dr * wi + di * wr;
+        zr[k] = sr - ti;
+        zi[k] = si + tr;
+    }
+
+    const int out = transform (true);
+    const float* xr = workRe[out].data();
+    const float* xi = workIm[out].data();
+
+    for (int n = 0; n < half; ++n)
+    {
+        time[2 * n] = xr[n];
+        time[2 * n + 1] = xi[n];
+    }
+}
+}
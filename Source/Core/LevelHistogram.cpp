@@ -0,0 +1,178 @@
+#include "LevelHistogram.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ultradyn
+{
+//==============================================================================
+void LevelHistogram::prepare (double sampleRate) noexcept
+{
+    publishInterval = untilPublish = std::max (1, (int) (0.1 * sampleRate));
+    windowSamples = (uint64_t) (60.0 * sampleRate);
+}
+
+void LevelHistogram::add (const float* meanSquare, int numSamples) noexcept
+{
+    if (resetRequested.exchange (false, std::memory_order_relaxed))
+    {
+        std::fill (&laneCounts[0][0], &laneCounts[0][0] + numLanes * numBins, 0u);
+        std::fill (std::begin (counts), std::end (counts), 0u);
+        total = 0;
+        untilPublish = 0; // show the cleared counts right away
+    }
+
+    // The bits of a positive float, read as an integer and scaled by 2^-23,
+    // are log2 of it plus 127, give or take 0.086; 0.043 centres the error.
+    // 10 log10 of a mean square is its RMS level in dB.
+    constexpr float dbPerLog2 = 3.01029996f;
+    constexpr float scale = dbPerLog2 / 8388608.0f;
+    constexpr float offset = dbPerLog2 * (0.043f - 127.0f) - minDb;
+    constexpr float lastBin = (float) (numBins - 1);
+
+    // Bins for a run of samples first (this loop vectorises), then the counts
+    constexpr int runLength = 64;
+    int32_t bins[runLength];
+
+    for (int start = 0; start < numSamples; start += runLength)
+    {
+        const int n = std::min (runLength, numSamples - start);
+
+        for (int i = 0; i < n; ++i)
+        {
+            int32_t bits;
+            std::memcpy (&bits, meanSquare + start + i, sizeof (bits));
+            const float bin = (float) bits * scale + offset;
+            bins[i] = (int32_t) (bin < 0.0f ? 0.0f : (bin > lastBin ? lastBin : bin));
+        }
+
+        for (int i = 0; i < n; ++i)
+            ++laneCounts[i & (numLanes - 1)][bins[i]];
+    }
+
+    total += (uint64_t) numSamples;
+
+    untilPublish -= numSamples;
+    if (untilPublish <= 0)
+    {
+        untilPublish = publishInterval;
+        publish();
+    }
+}
+
+void LevelHistogram::publish() noexcept
+{
+    for (auto& lane : laneCounts)
+    {
+        for (int b = 0; b < numBins; ++b)
+        {
+            counts[b] += lane[b];
+            lane[b] = 0;
+        }
+    }
+
+    if (total > windowSamples)
+    {
+        total = 0;
+        for (auto& c : counts)
+        {
+            c >>= 1;
+            total += c;
+        }
+    }
+
+    // Write the snapshot readers were not sent to last time
+    const int target = 1 - latest.load (std::memory_order_relaxed);
+    auto& s = snapshots[target];
+
+    const uint32_t seq = s.sequence.load (std::memory_order_relaxed);
+    s.sequence.store (seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+
+    for (int b = 0; b < numBins; ++b)
+        s.counts[b].store (counts[b], std::memory_order_relaxed);
+    s.total.store (total, std::memory_order_relaxed);
+
+    s.sequence.store (seq + 2, std::memory_order_release);
+    latest.store (target, std::memory_order_release);
+}
+
+uint64_t LevelHistogram::read (uint32_t* out) const noexcept
+{
+    for (;;)
+    {
+        const auto& s = snapshots[latest.load (std::memory_order_acquire)];
+
+        const uint32_t before = s.sequence.load (std::memory_order_acquire);
+        if ((before & 1u) != 0)
+            continue;
+
+        for (int b = 0; b < numBins; ++b)
+            out[b] = s.counts[b].load (std::memory_order_relaxed);
+        const uint64_t sum = s.total.load (std::memory_order_relaxed);
+
+        std::atomic_thread_fence (std::memory_order_acquire);
+        if (s.sequence.load (std::memory_order_relaxed) == before)
+            return sum;
+    }
+}
+
+//==============================================================================
+float LevelHistogram::percentileDb (const uint32_t* c, float share) noexcept
+{
+    uint64_t sum = 0;
+    for (int b = 0; b < numBins; ++b)
+        sum += c[b];
+
+    if (sum == 0)
+        return minDb;
+
+    const double target = (double) std::min (1.0f, std::max (0.0f, share)) * (double) sum;
+    double below = 0.0;
+    for (int b = 0; b < numBins; ++b)
+    {
+        if (c[b] > 0 && below + (double) c[b] >= target)
+            return minDb + (float) b + (float) ((target - below) / (double) c[b]);
+
+        below += (double) c[b];
+    }
+
+    return minDb + (float) numBins;
+}
+
+float LevelHistogram::thresholdForAverageDb (const uint32_t* c, StageDirection direction, StageSettings settings,
+                                             float targetDb, float minThreshold, float maxThreshold) noexcept
+{
+    uint64_t sum = 0;
+    for (int b = 0; b < numBins; ++b)
+        sum += c[b];
+
+    const bool upwards = direction == StageDirection::upwards;
+    if (sum == 0)
+        return upwards ? minThreshold : maxThreshold;
+
+    const auto averageDb = [&] (float threshold)
+    {
+        double weighted = 0.0;
+        for (int b = 0; b < numBins; ++b)
+        {
+            const float level = minDb + (float) b + 0.5f;
+            weighted += (double) c[b] * settings.curveDb (upwards ? threshold - level : level - threshold);
+        }
+        return (float) (weighted / (double) sum);
+    };
+
+    // The average only grows as the threshold moves into the material:
+    // down for the downwards stage, up for upwards
+    const float step = 0.1f;
+    const int numSteps = (int) ((maxThreshold - minThreshold) / step);
+    for (int i = 0; i <= numSteps; ++i)
+    {
+        const float threshold = upwards ? minThreshold + step * (float) i : maxThreshold - step * (float) i;
+        if (averageDb (threshold) >= targetDb)
+            return threshold;
+    }
+
+    return upwards ? maxThreshold : minThreshold;
+}
+}
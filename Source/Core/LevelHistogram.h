@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "CompressorStage.h"
+#include "UltraDynCore.h"
+
+namespace ultradyn
+{
+//==============================================================================
+// Distribution of one stage's detector level (RMS dB, as the threshold sees
+// it) over roughly the last minute, for threshold suggestions and display.
+//
+// The audio thread counts every detector sample into 1 dB bins: the bin comes
+// from the float's bit pattern (exponent and mantissa read as an approximate
+// log2, within 0.13 dB), a multiply-add that vectorises, and then costs an
+// increment. Neighbouring samples nearly always fall into the same bin, so
+// they count into four interleaved sets of bins, summed on publishing, rather
+// than waiting on each other's increments: about 1.1 ns per sample in all.
+// Every 100 ms the counts go into whichever of two snapshots readers are not
+// expected to be on, bracketed by a sequence number; readers retry on the rare
+// overlap. Once the counts pass a minute of samples they are halved, which
+// keeps the shape and lets old material fade.
+class LevelHistogram
+{
+public:
+    static constexpr int numBins = ULTRADYN_HISTOGRAM_BINS;
+    static constexpr float minDb = (float) ULTRADYN_HISTOGRAM_MIN_DB;
+
+    void prepare (double sampleRate) noexcept;
+
+    // Any thread; the audio thread clears the counts before its next add()
+    void requestReset() noexcept { resetRequested.store (true, std::memory_order_relaxed); }
+
+    // Audio thread: detector mean squares, one per sample
+    void add (const float* meanSquare, int numSamples) noexcept;
+
+    // Any thread: the last published counts; returns their total
+    uint64_t read (uint32_t* counts) const noexcept;
+
+    //==============================================================================
+    // Off the audio thread, on counts from read(). A level below which the
+    // given share (0..1) of the samples lies, interpolated within its bin.
+    static float percentileDb (const uint32_t* counts, float share) noexcept;
+
+    // The threshold at which a stage with these settings (threshold unused)
+    // would average targetDb of reduction (downwards) or lift (upwards) over
+    // the counted levels, searched across minThreshold..maxThreshold
+    static float thresholdForAverageDb (const uint32_t* counts, StageDirection direction, StageSettings settings,
+                                        float targetDb, float minThreshold, float maxThreshold) noexcept;
+
+private:
+    static constexpr int numLanes = 4;
+
+    uint32_t laneCounts[numLanes][numBins] {};
+    uint32_t counts[numBins] {};
+    uint64_t total = 0;
+    uint64_t windowSamples = 1;
+    int publishInterval = 1, untilPublish = 1;
+    std::atomic<bool> resetRequested { false };
+
+    struct Snapshot
+    {
+        std::atomic<uint32_t> sequence { 0 }; // odd while being written
+        std::atomic<uint32_t> counts[numBins] {};
+        std::atomic<uint64_t> total { 0 };
+    };
+
+    Snapshot snapshots[2];
+    std::atomic<int> latest { 0 };
+
+    void publish() noexcept;
+};
+}
@@ -0,0 +1,212 @@
+#include "LinkBus.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+
+#if ! defined (_WIN32)
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+ #define ULTRADYN_LINK_SHARED_MEMORY 1
+#else
+ #define ULTRADYN_LINK_SHARED_MEMORY 0
+#endif
+
+namespace ultradyn
+{
+//==============================================================================
+namespace
+{
+#if ULTRADYN_LINK_SHARED_MEMORY
+    // One segment per user and group. It is never unlinked: it is a few
+    // hundred bytes, and levels left over from an earlier session carry stale
+    // epoch tags, which members read as silence.
+    LinkGroup* mapSharedGroup (const char* name)
+    {
+        char path[64];
+        std::snprintf (path, sizeof (path), "/ultradyn.%u.%s", (unsigned) getuid(), name);
+
+        const int fd = shm_open (path, O_RDWR | O_CREAT, 0600);
+        if (fd < 0)
+            return nullptr;
+
+        // The first process to get here sizes it (zero-filled); others may
+        // race it, and macOS refuses to resize a segment twice
+        struct stat info;
+        bool sized = fstat (fd, &info) == 0 && info.st_size >= (off_t) sizeof (LinkGroup);
+        if (! sized)
+            sized = ftruncate (fd, (off_t) sizeof (LinkGroup)) == 0
+                 || (fstat (fd, &info) == 0 && info.st_size >= (off_t) sizeof (LinkGroup));
+
+        void* mapped = sized ? mmap (nullptr, sizeof (LinkGroup), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                             : MAP_FAILED;
+        close (fd);
+
+        return mapped != MAP_FAILED ? static_cast<LinkGroup*> (mapped) : nullptr;
+    }
+#endif
+
+    // The group's levels are stored as the top half of their float bits,
+    // rounded to nearest: 8 bits of mantissa, ordered like the floats for the
+    // non-negative values used here
+    inline uint32_t encodeLevel (float level) noexcept
+    {
+        uint32_t bits;
+        level = level > 0.0f ? level : 0.0f;
+        std::memcpy (&bits, &level, sizeof (bits));
+        return std::min<uint32_t> ((bits + 0x8000u) >> 16, 0x7f7fu);
+    }
+
+    inline float decodeLevel (uint32_t code) noexcept
+    {
+        const uint32_t bits = code << 16;
+        float level;
+        std::memcpy (&level, &bits, sizeof (level));
+        return level;
+    }
+
+    inline float bitsToFloat (uint32_t bits) noexcept
+    {
+        float f;
+        std::memcpy (&f, &bits, sizeof (f));
+        return f;
+    }
+
+    inline uint32_t floatToBits (float f) noexcept
+    {
+        uint32_t bits;
+        std::memcpy (&bits, &f, sizeof (bits));
+        return bits;
+    }
+
+    inline uint32_t tagOf (uint64_t cell) noexcept        { return (uint32_t) (cell >> 32); }
+    inline uint64_t makeCell (uint32_t tag, uint32_t v) noexcept { return ((uint64_t) tag << 32) | v; }
+
+    // Epochs wrap; a difference of under half the range decides the order
+    inline bool isBefore (uint32_t a, uint32_t b) noexcept { return (int32_t) (a - b) < 0; }
+
+    // Merges value into a cell for the given epoch: a cell from an earlier
+    // epoch is restarted, a later one means this member has fallen behind and
+    // its level is dropped. Relaxed ordering throughout: every cell carries
+    // its own tag and there is no other data to publish with it.
+    template <typename Merge>
+    inline void mergeIntoCell (std::atomic<uint64_t>& cell, uint32_t tag, uint32_t fresh, Merge merge) noexcept
+    {
+        uint64_t current = cell.load (std::memory_order_relaxed);
+        for (;;)
+        {
+            const uint32_t currentTag = tagOf (current);
+            if (isBefore (tag, currentTag))
+                return;
+
+            const uint64_t next = makeCell (tag, currentTag == tag ? merge ((uint32_t) current) : fresh);
+            if (cell.compare_exchange_weak (current, next, std::memory_order_relaxed))
+                return;
+        }
+    }
+}
+
+//==============================================================================
+LinkGroup* joinLinkGroup (const char* name)
+{
+    if (name == nullptr || *name == 0 || std::strlen (name) > 16 || std::strchr (name, '/') != nullptr)
+        return nullptr;
+
+    static std::mutex lock;
+    static std::map<std::string, LinkGroup*> groups;
+
+    const std::lock_guard<std::mutex> sl (lock);
+    auto& group = groups[name];
+
+   #if ULTRADYN_LINK_SHARED_MEMORY
+    if (group == nullptr)
+        group = mapSharedGroup (name);
+   #endif
+
+    // No shared memory (sandboxed, or Windows): link within this process
+    if (group == nullptr)
+        group = new (std::nothrow) LinkGroup();
+
+    return group;
+}
+
+//==============================================================================
+bool LinkMember::begin (float& othersLoudest, float& othersSum) noexcept
+{
+    othersLoudest = othersSum = 0.0f;
+
+    LinkGroup* g = pending.load (std::memory_order_acquire);
+    if (g != group)
+    {
+        group = g;
+        hasPublished = false;
+        if (g != nullptr)
+            epoch = g->epoch.load (std::memory_order_relaxed);
+    }
+
+    if (g == nullptr)
+        return false;
+
+    // Move the group on to this member's next epoch, or catch up with it
+    // when other members got there first (or this one stalled)
+    ++epoch;
+    uint32_t groupEpoch = g->epoch.load (std::memory_order_relaxed);
+    while (isBefore (groupEpoch, epoch))
+        if (g->epoch.compare_exchange_weak (groupEpoch, epoch, std::memory_order_relaxed))
+            groupEpoch = epoch;
+    epoch = groupEpoch;
+
+    // The previous epoch is complete for every member that keeps up; a cell
+    // with another tag belongs to an epoch nobody published in
+    const uint32_t previous = epoch - 1;
+    const int slot = (int) (previous % LinkGroup::ringSize);
+    const bool ownInPrevious = hasPublished && publishedEpoch == previous;
+
+    const uint64_t loudest = g->loudest[slot].load (std::memory_order_relaxed);
+    if (tagOf (loudest) == previous)
+    {
+        const uint32_t first = ((uint32_t) loudest >> 16) & 0xffffu;
+        const uint32_t second = (uint32_t) loudest & 0xffffu;
+        othersLoudest = decodeLevel (ownInPrevious && encodeLevel (publishedLevel) == first ? second : first);
+    }
+
+    const uint64_t sum = g->sum[slot].load (std::memory_order_relaxed);
+    if (tagOf (sum) == previous)
+        othersSum = std::max (0.0f, bitsToFloat ((uint32_t) sum) - (ownInPrevious ? publishedLevel : 0.0f));
+
+    return true;
+}
+
+void LinkMember::publish (float level) noexcept
+{
+    if (group == nullptr)
+        return;
+
+    level = level > 0.0f ? level : 0.0f;
+    const int slot = (int) (epoch % LinkGroup::ringSize);
+    const uint32_t code = encodeLevel (level);
+
+    mergeIntoCell (group->loudest[slot], epoch, code << 16, [code] (uint32_t v)
+    {
+        const uint32_t first = v >> 16, second = v & 0xffffu;
+        if (code >= first)  return (code << 16) | first;
+        if (code > second)  return (first << 16) | code;
+        return v;
+    });
+
+    mergeIntoCell (group->sum[slot], epoch, floatToBits (level), [level] (uint32_t v)
+    {
+        return floatToBits (bitsToFloat (v) + level);
+    });
+
+    publishedEpoch = epoch;
+    publishedLevel = level;
+    hasPublished = true;
+}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace ultradyn
+{
+//==============================================================================
+// Detector link between instances. Members of a group publish their detector
+// level once per process() call and apply the others' level from the previous
+// call, so linked instances duck together with at most one block of skew.
+//
+// A group is a few cache lines of plain atomics, placed in POSIX shared memory
+// so instances in different processes (hosts that sandbox plugins) link too.
+// Per epoch (one process() call of the group's fastest member) a cell holds
+// the two loudest levels and the sum of all levels, tagged with the epoch, in a
+// ring of four. Members merge into the current cell with one compare-exchange
+// each and read the previous one with a single load: no locks, no allocation,
+// no member list, and the same cost for two members as for thirty. A member
+// that stops processing drops out of the next epoch by itself.
+struct alignas (64) LinkGroup
+{
+    static constexpr int ringSize = 4;
+
+    std::atomic<uint32_t> epoch;
+
+    // (epoch << 32) | (loudest << 16) | second loudest, levels as the top
+    // 16 bits of their float (bfloat16), so a member can tell whether the
+    // loudest is its own
+    alignas (64) std::atomic<uint64_t> loudest[ringSize];
+
+    // (epoch << 32) | float bits of the sum
+    alignas (64) std::atomic<uint64_t> sum[ringSize];
+};
+
+static_assert (std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+               "link groups shared between processes need address-free atomics");
+
+// Finds or creates a group by name (up to 16 characters): shared memory where
+// the platform has it, otherwise shared within this process only. Groups are
+// never unmapped, so the pointer stays valid for the life of the process.
+// Locks and allocates: not for the audio thread. Returns nullptr on failure.
+LinkGroup* joinLinkGroup (const char* name);
+
+//==============================================================================
+// One instance's side of the link. setGroup() may be called from any thread;
+// begin() and publish() belong to the audio thread and are wait-free apart
+// from the compare-exchange retries of members publishing at the same moment.
+class LinkMember
+{
+public:
+    // Takes effect at the next begin(); nullptr leaves the group
+    void setGroup (LinkGroup* g) noexcept { pending.store (g, std::memory_order_release); }
+    LinkGroup* getGroup() const noexcept  { return pending.load (std::memory_order_acquire); }
+
+    // Starts a block: the loudest level and the level sum of the other members
+    // in the previous epoch. Returns false, with both 0, when not linked.
+    bool begin (float& othersLoudest, float& othersSum) noexcept;
+
+    // This member's level for the block begin() started
+    void publish (float level) noexcept;
+
+private:
+    std::atomic<LinkGroup*> pending { nullptr };
+    LinkGroup* group = nullptr;
+
+    uint32_t epoch = 0;
+    uint32_t publishedEpoch = 0;
+    float publishedLevel = 0.0f;
+    bool hasPublished = false;
+};
+}
@@ -0,0 +1,22 @@
+#include "ScratchArena.h"
+
+#include <cstring>
+
+namespace ultradyn
+{
+//==============================================================================
+void ScratchArena::allocate (const Layout& layout)
+{
+    // Over-allocate and align by hand: aligned operator new needs a newer
+    // runtime than the oldest macOS we support
+    sizeInBytes = layout.size;
+    storage.reset (new char[sizeInBytes + alignment]);
+
+    const auto address = reinterpret_cast<uintptr_t> (storage.get());
+    char* base = storage.get() + ((alignment - (address & (alignment - 1))) & (alignment - 1));
+    std::memset (base, 0, sizeInBytes);
+
+    for (const auto& r : layout.reservations)
+        r.bind (r.view, base, r.offset, r.count);
+}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ultradyn
+{
+//==============================================================================
+// A typed window onto part of a ScratchArena. Empty until the arena it was
+// reserved in is allocated; it does not own its memory.
+template <typename T>
+class ArenaView
+{
+public:
+    T* data() const noexcept            { return elements; }
+    size_t size() const noexcept        { return count; }
+    T* begin() const noexcept           { return elements; }
+    T* end() const noexcept             { return elements + count; }
+    T& operator[] (size_t i) const noexcept { return elements[i]; }
+
+private:
+    friend class ScratchArena;
+    T* elements = nullptr;
+    size_t count = 0;
+};
+
+//==============================================================================
+// One 64-byte aligned, zeroed block holding every buffer the audio thread
+// works in: per-channel scratch, delay lines, frames and gain curves. Owners
+// reserve their views in a Layout while preparing, then the arena allocates
+// once and points every view into it, each on its own cache line and laid out
+// in reservation order, so buffers used together sit together. Nothing is
+// allocated after that until the next prepare.
+class ScratchArena
+{
+public:
+    static constexpr size_t alignment = 64;
+
+    class Layout
+    {
+    public:
+        // view gets count elements of T once the arena is allocated
+        template <typename T>
+        void reserve (ArenaView<T>& view, size_t count)
+        {
+            static_assert (alignof (T) <= alignment, "arena blocks are cache-line aligned");
+            reservations.push_back ({ &view, size, count, [] (void* v, char* base, size_t offset, size_t n)
+            {
+                auto& target = *static_cast<ArenaView<T>*> (v);
+                target.elements = reinterpret_cast<T*> (base + offset);
+                target.count = n;
+            }});
+
+            size += (count * sizeof (T) + alignment - 1) & ~(alignment - 1);
+        }
+
+        size_t getSizeInBytes() const noexcept { return size; }
+
+    private:
+        friend class ScratchArena;
+
+        struct Reservation
+        {
+            void* view;
+            size_t offset, count;
+            void (*bind) (void* view, char* base, size_t offset, size_t count);
+        };
+
+        std::vector<Reservation> reservations;
+        size_t size = 0;
+    };
+
+    // Replaces the previous block (and invalidates the views into it)
+    void allocate (const Layout& layout);
+
+    size_t getSizeInBytes() const noexcept { return sizeInBytes; }
+
+private:
+    std::unique_ptr<char[]> storage;
+    size_t sizeInBytes = 0;
+};
+}
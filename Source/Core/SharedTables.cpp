@@ -0,0 +1,87 @@
+#include "SharedTables.h"
+
+#include <map>
+#include <mutex>
+
+namespace ultradyn
+{
+//==============================================================================
+DSPTables::DSPTables (double sr)
+    : sampleRate (sr)
+{
+    const int numDbPoints = (int) ((maxDb - minDb) * dbTableScale) + 2; // +1 guard for interpolation
+    dbToGainTable.resize ((size_t) numDbPoints);
+    for (int i = 0; i < numDbPoints; ++i)
+        dbToGainTable[(size_t) i] = (float) std::pow (10.0, (minDb + (double) i * dbTableStep) / 20.0);
+
+    const double logMin = std::log10 ((double) minTimeMs);
+    const double logMax = std::log10 ((double) maxTimeMs);
+    timeCoeffTable.resize ((size_t) timeTableSize + 1);
+    for (int i = 0; i <= timeTableSize; ++i)
+    {
+        const double ms = std::pow (10.0, logMin + (logMax - logMin) * i / timeTableSize);
+        timeCoeffTable[(size_t) i] = (float) std::exp (-1.0 / (ms * 0.001 * sampleRate + 1.0));
+    }
+}
+
+float DSPTables::timeConstantToCoeff (float ms) const noexcept
+{
+    static const float logMin = std::log10 (minTimeMs);
+    static const float logScale = (float) timeTableSize / (std::log10 (maxTimeMs) - logMin);
+
+    const float clamped = std::fmin (std::fmax (ms, minTimeMs), maxTimeMs);
+    const float pos = (std::log10 (clamped) - logMin) * logScale;
+    const int i = std::min ((int) pos, timeTableSize - 1);
+    const float frac = pos - (float) i;
+    return timeCoeffTable[(size_t) i] + frac * (timeCoeffTable[(size_t) i + 1] - timeCoeffTable[(size_t) i]);
+}
+
+size_t DSPTables::getSizeInBytes() const noexcept
+{
+    return sizeof (*this)
+         + dbToGainTable.capacity() * sizeof (float)
+         + timeCoeffTable.capacity() * sizeof (float);
+}
+
+//==============================================================================
+namespace
+{
+    std::mutex& getCacheLock()
+    {
+        static std::mutex lock;
+        return lock;
+    }
+
+    std::map<double, std::weak_ptr<const DSPTables>>& getCache()
+    {
+        static std::map<double, std::weak_ptr<const DSPTables>> cache;
+        return cache;
+    }
+}
+
+std::shared_ptr<const DSPTables> SharedTables::get (double sampleRate)
+{
+    const std::lock_guard<std::mutex> sl (getCacheLock());
+    auto& cache = getCache();
+
+    // Drop entries whose last user has gone
+    for (auto it = cache.begin(); it != cache.end();)
+        it = it->second.expired() ? cache.erase (it) : std::next (it);
+
+    if (auto existing = cache[sampleRate].lock())
+        return existing;
+
+    auto tables = std::make_shared<const DSPTables> (sampleRate);
+    cache[sampleRate] = tables;
+    return tables;
+}
+
+int SharedTables::getNumLiveTableSets()
+{
+    const std::lock_guard<std::mutex> sl (getCacheLock());
+    int count = 0;
+    for (auto& entry : getCache())
+        count += entry.second.expired() ? 0 : 1;
+    return count;
+}
+}
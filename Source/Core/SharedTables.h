@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace ultradyn
+{
+//==============================================================================
+// Immutable lookup tables shared by every processor instance in the process.
+//
+// Tables are built once per sample rate and handed out as reference-counted
+// const pointers; the last instance releasing a sample rate frees its tables.
+// Acquire them from prepareToPlay, never from the audio thread.
+class DSPTables
+{
+public:
+    explicit DSPTables (double sampleRate);
+
+    double getSampleRate() const noexcept { return sampleRate; }
+
+    // Linear gain for a dB value, interpolated (error < 0.001 dB in range)
+    inline float decibelsToGain (float dB) const noexcept
+    {
+        // std::min/max inline to single instructions where fmin/fmax are calls;
+        // in this order a NaN clamps to minDb
+        const float pos = (std::min (maxDb, std::max (minDb, dB)) - minDb) * dbTableScale;
+        const int i = (int) pos;
+        const float frac = pos - (float) i;
+        return dbToGainTable[(size_t) i] + frac * (dbToGainTable[(size_t) i + 1] - dbToGainTable[(size_t) i]);
+    }
+
+    // dB value for a linear gain via a polynomial log2 (error < 0.002 dB),
+    // floored at minusInfinityDb like juce::Decibels::gainToDecibels. Only the
+    // floor cuts off, so a lower one (as for mean squares) reaches further down.
+    static inline float gainToDecibels (float gain, float minusInfinityDb = -100.0f) noexcept
+    {
+        if (! (gain > 0.0f))
+            return minusInfinityDb;
+
+        uint32_t bits;
+        std::memcpy (&bits, &gain, sizeof (bits));
+        const float exponent = (float) ((bits >> 23) & 0xffu) - 127.0f;
+        bits = (bits & 0x007fffffu) | 0x3f800000u; // mantissa in [1, 2)
+        float m;
+        std::memcpy (&m, &bits, sizeof (m));
+
+        // Least-squares fit of log2(m) on [1, 2)
+        const float log2m = ((((log2Poly[0] * m + log2Poly[1]) * m + log2Poly[2]) * m + log2Poly[3]) * m + log2Poly[4]);
+        return std::max (minusInfinityDb, 6.0205999f * (exponent + log2m));
+    }
+
+    // One-pole smoothing coefficient for a time constant in milliseconds,
+    // matching exp (-1 / (ms * 0.001 * sr + 1)) within 1e-6
+    float timeConstantToCoeff (float ms) const noexcept;
+
+    // Bytes owned by this table set (for footprint reports)
+    size_t getSizeInBytes() const noexcept;
+
+    static constexpr float minDb = -120.0f;
+    static constexpr float maxDb = 48.0f;
+
+private:
+    static constexpr float dbTableStep = 0.05f;
+    static constexpr float dbTableScale = 1.0f / dbTableStep;
+    static constexpr float log2Poly[5] = { -0.07915382f, 0.6288414f, -2.081128f, 4.02845f, -2.496806f };
+
+    static constexpr float minTimeMs = 0.01f;
+    static constexpr float maxTimeMs = 10000.0f;
+    static constexpr int timeTableSize = 2048;
+
+    double sampleRate;
+    std::vector<float> dbToGainTable;
+    std::vector<float> timeCoeffTable; // indexed by log10 (ms)
+};
+
+//==============================================================================
+// Process-wide cache of DSPTables keyed by sample rate
+struct SharedTables
+{
+    static std::shared_ptr<const DSPTables> get (double sampleRate);
+
+    // Number of distinct sample rates currently held alive
+    static int getNumLiveTableSets();
+};
+}
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define ULTRADYN_SIDECHAIN_SSE2 1
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+ #include <arm_neon.h>
+ #define ULTRADYN_SIDECHAIN_NEON 1
+#endif
+
+namespace ultradyn
+{
+//==============================================================================
+// Normalised biquad coefficients (a0 == 1), RBJ cookbook designs
+struct BiquadCoeffs
+{
+    float b0 { 1.0f }, b1 { 0.0f }, b2 { 0.0f }, a1 { 0.0f }, a2 { 0.0f };
+
+    static BiquadCoeffs identity() noexcept { return {}; }
+
+    static BiquadCoeffs highPass (double sr, double freq, float q) noexcept
+    {
+        const float w0    = twoPi * clampFreq (sr, freq) / (float) sr;
+        const float cw0   = std::cos (w0);
+        const float alpha = std::sin (w0) / (2.0f * std::max (1.0e-6f, q));
+
+        return normalise ((1.0f + cw0) * 0.5f, -(1.0f + cw0), (1.0f + cw0) * 0.5f,
+                          1.0f + alpha, -2.0f * cw0, 1.0f - alpha);
+    }
+
+    static BiquadCoeffs peak (double sr, double freq, float q, float gainDb) noexcept
+    {
+        const float A     = std::pow (10.0f, gainDb * 0.025f); // 10^(dB/40)
+        const float w0    = twoPi * clampFreq (sr, freq) / (float) sr;
+        const float cw0   = std::cos (w0);
+        const float alpha = std::sin (w0) / (2.0f * std::max (1.0e-6f, q));
+
+        return normalise (1.0f + alpha * A, -2.0f * cw0, 1.0f - alpha * A,
+                          1.0f + alpha / A, -2.0f * cw0, 1.0f - alpha / A);
+    }
+
+    // Shelves use a shelf slope of 1 (alpha = sin(w0) / sqrt(2))
+    static BiquadCoeffs lowShelf (double sr, double freq, float gainDb) noexcept
+    {
+        const float A     = std::pow (10.0f, gainDb * 0.025f);
+        const float w0    = twoPi * clampFreq (sr, freq) / (float) sr;
+        const float cw0   = std::cos (w0);
+        const float beta  = 2.0f * std::sqrt (A) * std::sin (w0) * 0.70710678f;
+
+        return normalise (A * ((A + 1.0f) - (A - 1.0f) * cw0 + beta),
+                          2.0f * A * ((A - 1.0f) - (A + 1.0f) * cw0),
+                          A * ((A + 1.0f) - (A - 1.0f) * cw0 - beta),
+                          (A + 1.0f) + (A - 1.0f) * cw0 + beta,
+                          -2.0f * ((A - 1.0f) + (A + 1.0f) * cw0),
+                          (A + 1.0f) + (A - 1.0f) * cw0 - beta);
+    }
+
+    static BiquadCoeffs highShelf (double sr, double freq, float gainDb) noexcept
+    {
+        const float A     = std::pow (10.0f, gainDb * 0.025f);
+        const float w0    = twoPi * clampFreq (sr, freq) / (float) sr;
+        const float cw0   = std::cos (w0);
+        const float beta  = 2.0f * std::sqrt (A) * std::sin (w0) * 0.70710678f;
+
+        return normalise (A * ((A + 1.0f) + (A - 1.0f) * cw0 + beta),
+                          -2.0f * A * ((A - 1.0f) + (A + 1.0f) * cw0),
+                          A * ((A + 1.0f) + (A - 1.0f) * cw0 - beta),
+                          (A + 1.0f) - (A - 1.0f) * cw0 + beta,
+                          2.0f * ((A - 1.0f) - (A + 1.0f) * cw0),
+                          (A + 1.0f) - (A - 1.0f) * cw0 - beta);
+    }
+
+private:
+    static constexpr float twoPi = 6.283185307f;
+
+    // Keep designs below Nyquist whatever the host sample rate
+    static float clampFreq (double sr, double freq) noexcept
+    {
+        return (float) std::min (std::max (freq, 1.0), 0.45 * sr);
+    }
+
+    static BiquadCoeffs normalise (float b0, float b1, float b2, float a0, float a1, float a2) noexcept
+    {
+        const float invA0 = 1.0f / a0;
+        return { b0 * invA0, b1 * invA0, b2 * invA0, a1 * invA0, a2 * invA0 };
+    }
+};
+
+//==============================================================================
+// Coefficients, glide increments and state of a four-lane biquad cascade
+struct alignas (16) BiquadCascadeState
+{
+    static constexpr int numLanes = 4;
+
+    float b0[numLanes], b1[numLanes], b2[numLanes], a1[numLanes], a2[numLanes];
+    float db0[numLanes], db1[numLanes], db2[numLanes], da1[numLanes], da2[numLanes];
+    float z1[numLanes], z2[numLanes], out[numLanes];
+};
+
+// Filters data[start, end) in place; when ramping, the increments are added to
+// the coefficients every sample. Implementations are selected at run time (see
+// DSPKernels.h); every one of them computes the same recurrence.
+using BiquadCascadeFn = void (*) (BiquadCascadeState&, float* data, int start, int end, bool ramping);
+
+namespace cascade
+{
+    struct ScalarOps
+    {
+        struct Vec { float v[4]; };
+        static Vec load (const float* p) noexcept                { return { { p[0], p[1], p[2], p[3] } }; }
+        static void store (float* p, Vec v) noexcept             { std::copy (v.v, v.v + 4, p); }
+        static Vec add (Vec a, Vec b) noexcept                   { return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+        static Vec sub (Vec a, Vec b) noexcept                   { return { { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } }; }
+        static Vec mul (Vec a, Vec b) noexcept                   { return { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } }; }
+        static float lastLane (Vec v) noexcept                   { return v.v[3]; }
+        static Vec shiftIn (float x, Vec v) noexcept             { return { { x, v.v[0], v.v[1], v.v[2] } }; }
+    };
+
+#if ULTRADYN_SIDECHAIN_SSE2
+    struct SSE2Ops
+    {
+        using Vec = __m128;
+        static Vec load (const float* p) noexcept                { return _mm_load_ps (p); }
+        static void store (float* p, Vec v) noexcept             { _mm_store_ps (p, v); }
+        static Vec add (Vec a, Vec b) noexcept                   { return _mm_add_ps (a, b); }
+        static Vec sub (Vec a, Vec b) noexcept                   { return _mm_sub_ps (a, b); }
+        static Vec mul (Vec a, Vec b) noexcept                   { return _mm_mul_ps (a, b); }
+        static float lastLane (Vec v) noexcept                   { return _mm_cvtss_f32 (_mm_shuffle_ps (v, v, _MM_SHUFFLE (3, 3, 3, 3))); }
+
+        // { x, v0, v1, v2 }
+        static Vec shiftIn (float x, Vec v) noexcept
+        {
+            const Vec shifted = _mm_castsi128_ps (_mm_slli_si128 (_mm_castps_si128 (v), 4));
+            return _mm_move_ss (shifted, _mm_set_ss (x));
+        }
+    };
+
+    using NativeOps = SSE2Ops;
+#elif ULTRADYN_SIDECHAIN_NEON
+    struct NeonOps
+    {
+        using Vec = float32x4_t;
+        static Vec load (const float* p) noexcept                { return vld1q_f32 (p); }
+        static void store (float* p, Vec v) noexcept             { vst1q_f32 (p, v); }
+        static Vec add (Vec a, Vec b) noexcept                   { return vaddq_f32 (a, b); }
+        static Vec sub (Vec a, Vec b) noexcept                   { return vsubq_f32 (a, b); }
+        static Vec mul (Vec a, Vec b) noexcept                   { return vmulq_f32 (a, b); }
+        static float lastLane (Vec v) noexcept                   { return vgetq_lane_f32 (v, 3); }
+        static Vec shiftIn (float x, Vec v) noexcept             { return vextq_f32 (vdupq_n_f32 (x), v, 3); }
+    };
+
+    using NativeOps = NeonOps;
+#else
+    using NativeOps = ScalarOps;
+#endif
+
+    // Transposed direct-form II, one stage per lane with a one-sample skew
+    template <typename Ops, bool ramping>
+    inline void run (BiquadCascadeState& s, float* data, int start, int end) noexcept
+    {
+        using Vec = typename Ops::Vec;
+        Vec vb0 = Ops::load (s.b0), vb1 = Ops::load (s.b1), vb2 = Ops::load (s.b2), va1 = Ops::load (s.a1), va2 = Ops::load (s.a2);
+        Vec vz1 = Ops::load (s.z1), vz2 = Ops::load (s.z2), vy = Ops::load (s.out);
+
+        Vec vdb0 {}, vdb1 {}, vdb2 {}, vda1 {}, vda2 {};
+        if (ramping)
+        {
+            vdb0 = Ops::load (s.db0); vdb1 = Ops::load (s.db1); vdb2 = Ops::load (s.db2);
+            vda1 = Ops::load (s.da1); vda2 = Ops::load (s.da2);
+        }
+
+        for (int n = start; n < end; ++n)
+        {
+            if (ramping)
+            {
+                vb0 = Ops::add (vb0, vdb0); vb1 = Ops::add (vb1, vdb1); vb2 = Ops::add (vb2, vdb2);
+                va1 = Ops::add (va1, vda1); va2 = Ops::add (va2, vda2);
+            }
+
+            // Each lane takes the previous output of the stage before it
+            const Vec x = Ops::shiftIn (data[n], vy);
+
+            vy  = Ops::add (Ops::mul (vb0, x), vz1);
+            vz1 = Ops::add (Ops::sub (Ops::mul (vb1, x), Ops::mul (va1, vy)), vz2);
+            vz2 = Ops::sub (Ops::mul (vb2, x), Ops::mul (va2, vy));
+
+            data[n] = Ops::lastLane (vy);
+        }
+
+        Ops::store (s.z1, vz1); Ops::store (s.z2, vz2); Ops::store (s.out, vy);
+
+        if (ramping)
+        {
+            Ops::store (s.b0, vb0); Ops::store (s.b1, vb1); Ops::store (s.b2, vb2);
+            Ops::store (s.a1, va1); Ops::store (s.a2, va2);
+        }
+    }
+
+    template <typename Ops>
+    void process (BiquadCascadeState& s, float* data, int start, int end, bool ramping) noexcept
+    {
+        if (ramping) run<Ops, true>  (s, data, start, end);
+        else         run<Ops, false> (s, data, start, end);
+    }
+}
+
+//==============================================================================
+// Four-stage sidechain EQ (HPF -> low shelf -> peak -> high shelf) for the
+// detector path.
+//
+// The stages run side by side in the four lanes of one SIMD register with a
+// one-sample skew: on each tick lane k filters what lane k-1 produced on the
+// previous tick. One tick costs about as much as one scalar transposed
+// direct-form II biquad, and the output trails the input by three samples,
+// which is irrelevant for a detector.
+//
+// Coefficient changes can be glided linearly over a number of samples; the
+// stable (a1, a2) region is a triangle, so every interpolated filter is stable.
+class SidechainEQ
+{
+public:
+    enum Stage { highPassStage = 0, lowShelfStage, peakStage, highShelfStage, numStages };
+
+    static constexpr int latencySamples = numStages - 1;
+    static_assert (numStages == BiquadCascadeState::numLanes, "one stage per lane");
+
+    SidechainEQ() noexcept
+    {
+        for (int s = 0; s < numStages; ++s)
+            setStage (s, BiquadCoeffs::identity());
+        commit (0);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        std::fill (state.z1, state.z1 + numStages, 0.0f);
+        std::fill (state.z2, state.z2 + numStages, 0.0f);
+        std::fill (state.out, state.out + numStages, 0.0f);
+    }
+
+    // Compiled-in SIMD path by default; prepareToPlay may swap in a dispatched kernel
+    void setKernel (BiquadCascadeFn newKernel) noexcept { kernel = newKernel; }
+
+    // Stages new target coefficients; they take effect on commit()
+    void setStage (int stage, const BiquadCoeffs& c) noexcept
+    {
+        tb0[stage] = c.b0; tb1[stage] = c.b1; tb2[stage] = c.b2;
+        ta1[stage] = c.a1; ta2[stage] = c.a2;
+    }
+
+    // Applies the staged coefficients immediately or over rampSamples samples
+    void commit (int rampSamples) noexcept
+    {
+        auto& s = state;
+
+        if (rampSamples <= 0)
+        {
+            std::copy (tb0, tb0 + numStages, s.b0); std::copy (tb1, tb1 + numStages, s.b1);
+            std::copy (tb2, tb2 + numStages, s.b2); std::copy (ta1, ta1 + numStages, s.a1);
+            std::copy (ta2, ta2 + numStages, s.a2);
+            rampRemaining = 0;
+            return;
+        }
+
+        const float inv = 1.0f / (float) rampSamples;
+        for (int i = 0; i < numStages; ++i)
+        {
+            s.db0[i] = (tb0[i] - s.b0[i]) * inv; s.db1[i] = (tb1[i] - s.b1[i]) * inv;
+            s.db2[i] = (tb2[i] - s.b2[i]) * inv; s.da1[i] = (ta1[i] - s.a1[i]) * inv;
+            s.da2[i] = (ta2[i] - s.a2[i]) * inv;
+        }
+        rampRemaining = rampSamples;
+    }
+
+    // Filters a block in place
+    void process (float* data, int numSamples) noexcept
+    {
+        int n = 0;
+
+        if (rampRemaining > 0)
+        {
+            const int rampEnd = std::min (rampRemaining, numSamples);
+            kernel (state, data, 0, rampEnd, true);
+            rampRemaining -= rampEnd;
+            if (rampRemaining == 0)
+                commit (0);
+            n = rampEnd;
+        }
+
+        kernel (state, data, n, numSamples, false);
+    }
+
+private:
+    BiquadCascadeState state;
+    alignas (16) float tb0[numStages], tb1[numStages], tb2[numStages], ta1[numStages], ta2[numStages];
+    int rampRemaining = 0;
+    BiquadCascadeFn kernel = cascade::process<cascade::NativeOps>;
+};
+}
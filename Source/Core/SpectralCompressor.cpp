@@ -0,0 +1,211 @@
+#include "SpectralCompressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace ultradyn
+{
+//==============================================================================
+void SpectralCompressor::prepare (int numChannels, int maxBlockSize, const kernels::Table& kernelTable,
+                                  ScratchArena::Layout& scratch)
+{
+    dsp = &kernelTable;
+    numCh = std::max (1, numChannels);
+    maxBlock = std::max (1, maxBlockSize);
+
+    fft.prepare (fftSize);
+
+    // Periodic sqrt-Hann: sin^2 at half-frame offsets sums to one
+    analysisWindow.resize ((size_t) fftSize);
+    synthesisWindow.resize ((size_t) fftSize);
+    double windowSum = 0.0, leakRe = 0.0, leakIm = 0.0;
+    for (int i = 0; i < fftSize; ++i)
+    {
+        const double w = std::sin (M_PI * (double) i / (double) fftSize);
+        analysisWindow[(size_t) i] = (float) w;
+        synthesisWindow[(size_t) i] = (float) (w / (double) fftSize);
+        windowSum += w;
+        leakRe += w * std::cos (2.0 * M_PI * (double) i / (double) fftSize);
+        leakIm += w * std::sin (2.0 * M_PI * (double) i / (double) fftSize);
+    }
+
+    // A sine of amplitude A centred on a bin gives |X| = A / 2 * sum (w) there
+    // and leaks (a third of that for this window) into each neighbour. Bins
+    // detect on the power of three bins, scaled to read the sine's mean
+    // square, A^2 / 2: a peak and its skirts then get the same gain
+    const double leak = (leakRe * leakRe + leakIm * leakIm) / (windowSum * windowSum);
+    powerScale = (float) (2.0 / (windowSum * windowSum * (1.0 + 2.0 * leak)));
+
+    const auto channelsOf = [this] (int length) { return (size_t) numCh * (size_t) length; };
+    scratch.reserve (inputFifo, channelsOf (fftSize));
+    scratch.reserve (outputAccum, channelsOf (fftSize));
+    scratch.reserve (outputReady, channelsOf (hopSize));
+    scratch.reserve (dryLines, channelsOf (fftSize + maxBlock));
+
+    scratch.reserve (frame, (size_t) fftSize);
+    scratch.reserve (spectrumRe, channelsOf (paddedBins));
+    scratch.reserve (spectrumIm, channelsOf (paddedBins));
+    scratch.reserve (power, (size_t) numBins);
+    scratch.reserve (level, (size_t) paddedBins);
+    scratch.reserve (downGains, (size_t) paddedBins);
+    scratch.reserve (upGains, (size_t) paddedBins);
+    scratch.reserve (gains, (size_t) paddedBins);
+}
+
+void SpectralCompressor::reset() noexcept
+{
+    std::fill (inputFifo.begin(), inputFifo.end(), 0.0f);
+    std::fill (outputAccum.begin(), outputAccum.end(), 0.0f);
+    std::fill (outputReady.begin(), outputReady.end(), 0.0f);
+    std::fill (dryLines.begin(), dryLines.end(), 0.0f);
+    std::fill (downGains.begin(), downGains.end(), 1.0f);
+    std::fill (upGains.begin(), upGains.end(), 1.0f);
+    fill = 0;
+    gainReductionDb = upwardsGainDb = 0.0f;
+}
+
+size_t SpectralCompressor::getMemoryFootprintBytes() const noexcept
+{
+    // The buffers are in the owner's arena. The FFT's twiddles and work
+    // buffers come to about four transform lengths.
+    const size_t floats = analysisWindow.capacity() + synthesisWindow.capacity();
+    return floats * sizeof (float) + 4 * (size_t) fftSize * sizeof (float);
+}
+
+//==============================================================================
+void SpectralCompressor::process (float* const* dry, int dryOffset, float* const* wet, int numChannels, int numSamples,
+                                  const Stage& downwards, const Stage& upwards) noexcept
+{
+    const int channels = std::min (numChannels, numCh);
+    if (channels <= 0)
+        return;
+
+    frameChannels = channels;
+
+    // Settings are picked up at the next frame; attack and release become
+    // coefficients per hop
+    const auto setStage = [this] (const Stage& stage, int first)
+    {
+        const auto& s = stage.settings;
+        settings[first + spectral::threshold] = s.threshold;
+        settings[first + spectral::slope]     = stage.active ? s.slope : 0.0f;
+        settings[first + spectral::halfKnee]  = s.halfKnee;
+        settings[first + spectral::invKnee]   = s.invKnee;
+        settings[first + spectral::attack]    = std::pow (stage.attackCoeff, (float) hopSize);
+        settings[first + spectral::release]   = std::pow (stage.releaseCoeff, (float) hopSize);
+        settings[first + spectral::dry]       = stage.active ? (1.0f - s.mix) * s.stageGain : 1.0f;
+        settings[first + spectral::wet]       = stage.active ? s.mix * s.stageGain : 0.0f;
+    };
+    setStage (downwards, 0);
+    setStage (upwards, spectral::upThreshold);
+
+    for (int start = 0; start < numSamples; start += maxBlock)
+    {
+        const int n = std::min (maxBlock, numSamples - start);
+
+        // Dry: through a plain delay of the same length
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            float* line = dryLines.data() + (size_t) ch * (size_t) (fftSize + maxBlock);
+            float* io = dry[ch] + dryOffset + start;
+            std::memcpy (line + fftSize, io, (size_t) n * sizeof (float));
+            std::memcpy (io, line, (size_t) n * sizeof (float));
+            std::memmove (line, line + n, (size_t) fftSize * sizeof (float));
+        }
+
+        // Wet: in through the newest hop of the FIFO, out of the finished one
+        for (int done = 0; done < n;)
+        {
+            const int take = std::min (hopSize - fill, n - done);
+
+            for (int ch = 0; ch < channels; ++ch)
+            {
+                float* io = wet[ch] + start + done;
+                float* in = inputFifo.data() + (size_t) ch * fftSize + (fftSize - hopSize) + fill;
+                const float* out = outputReady.data() + (size_t) ch * hopSize + fill;
+                std::memcpy (in, io, (size_t) take * sizeof (float));
+                std::memcpy (io, out, (size_t) take * sizeof (float));
+            }
+
+            fill += take;
+            done += take;
+
+            if (fill == hopSize)
+            {
+                processFrame();
+                fill = 0;
+            }
+        }
+    }
+}
+
+void SpectralCompressor::processFrame() noexcept
+{
+    // Analysis, and the channels' mean power per bin
+    std::fill (power.begin(), power.end(), 0.0f);
+    for (int ch = 0; ch < frameChannels; ++ch)
+    {
+        const float* in = inputFifo.data() + (size_t) ch * fftSize;
+        float* re = spectrumRe.data() + (size_t) ch * paddedBins;
+        float* im = spectrumIm.data() + (size_t) ch * paddedBins;
+
+        for (int i = 0; i < fftSize; ++i)
+            frame[(size_t) i] = in[i] * analysisWindow[(size_t) i];
+
+        fft.forward (frame.data(), re, im);
+
+        for (int k = 0; k < numBins; ++k)
+            power[(size_t) k] += re[k] * re[k] + im[k] * im[k];
+    }
+
+    // Three-bin bands, mirrored at the ends
+    const float scale = powerScale / (float) frameChannels;
+    level[0] = (power[0] + 2.0f * power[1]) * scale;
+    for (int k = 1; k < numBins - 1; ++k)
+        level[(size_t) k] = (power[(size_t) k - 1] + power[(size_t) k] + power[(size_t) k + 1]) * scale;
+    level[(size_t) numBins - 1] = (power[(size_t) numBins - 1] + 2.0f * power[(size_t) numBins - 2]) * scale;
+
+    dsp->spectralGains (settings, level.data(), downGains.data(), upGains.data(), gains.data(), paddedBins);
+
+    // Synthesis: gain, inverse, window, overlap-add; the first hop of the
+    // accumulator is then complete
+    for (int ch = 0; ch < frameChannels; ++ch)
+    {
+        float* re = spectrumRe.data() + (size_t) ch * paddedBins;
+        float* im = spectrumIm.data() + (size_t) ch * paddedBins;
+        for (int k = 0; k < numBins; ++k)
+        {
+            re[k] *= gains[(size_t) k];
+            im[k] *= gains[(size_t) k];
+        }
+
+        fft.inverse (re, im, frame.data());
+
+        float* accum = outputAccum.data() + (size_t) ch * fftSize;
+        for (int i = 0; i < fftSize; ++i)
+            accum[i] += frame[(size_t) i] * synthesisWindow[(size_t) i];
+
+        std::memcpy (outputReady.data() + (size_t) ch * hopSize, accum, (size_t) hopSize * sizeof (float));
+        std::memmove (accum, accum + hopSize, (size_t) (fftSize - hopSize) * sizeof (float));
+        std::fill (accum + fftSize - hopSize, accum + fftSize, 0.0f);
+
+        float* in = inputFifo.data() + (size_t) ch * fftSize;
+        std::memmove (in, in + hopSize, (size_t) (fftSize - hopSize) * sizeof (float));
+    }
+
+    // Meters: the stages' smoothed gains, weighted by the power they act on
+    double total = 0.0, afterDown = 0.0, afterUp = 0.0;
+    for (int k = 0; k < numBins; ++k)
+    {
+        const double p = level[(size_t) k];
+        const double down = p * downGains[(size_t) k] * downGains[(size_t) k];
+        total += p;
+        afterDown += down;
+        afterUp += down * upGains[(size_t) k] * upGains[(size_t) k];
+    }
+
+    gainReductionDb = total > 1.0e-12 ? (float) std::min (60.0, std::max (0.0, -10.0 * std::log10 (afterDown / total + 1.0e-18))) : 0.0f;
+    upwardsGainDb = afterDown > 1.0e-12 ? (float) std::min (20.0, std::max (0.0, 10.0 * std::log10 (afterUp / afterDown + 1.0e-18))) : 0.0f;
+}
+}
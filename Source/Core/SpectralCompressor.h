@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+
+#include "BatchKernel.h"
+#include "CompressorStage.h"
+#include "DSPKernels.h"
+#include "FFT.h"
+#include "ScratchArena.h"
+#include "SpectralKernel.h"
+
+namespace ultradyn
+{
+//==============================================================================
+// Spectral mode: both stages' curves applied per frequency bin instead of to
+// the whole signal, for de-harshing (downwards) and lifting quiet parts of
+// the spectrum (upwards). 1024-point frames with 50% overlap, square-root
+// Hann windows on analysis and synthesis (their product overlap-adds to
+// one), linked across channels: each bin's detector is the channels' mean
+// power in it, and every channel gets the same gain.
+//
+// A bin detects on the band of it and its two neighbours, scaled so a sine
+// centred on it reads its RMS level, the same as on the broadband detector;
+// threshold, ratio, knee, mix and output gain mean the same as there, and
+// attack and release smooth each bin's gain at the frame rate. The output is delayed by one frame (fftSize samples).
+// Its buffers live in the owner's scratch arena.
+class SpectralCompressor
+{
+public:
+    static constexpr int fftSize = 1024;
+    static constexpr int hopSize = fftSize / 2;
+    static constexpr int numBins = fftSize / 2 + 1;
+
+    // Reserves the buffers in scratch; reset() once the arena is allocated
+    void prepare (int numChannels, int maxBlockSize, const kernels::Table& dsp, ScratchArena::Layout& scratch);
+    void reset() noexcept;
+
+    // A stage's curve and its attack/release coefficients per sample; an
+    // inactive stage passes the signal untouched
+    struct Stage
+    {
+        StageSettings settings;
+        float attackCoeff = 0.0f, releaseCoeff = 0.0f;
+        bool active = true;
+    };
+
+    // wet[ch][i] is processed in place. dry[ch][dryOffset + i] is delayed in
+    // place by the same latency, so the two stay aligned for mixing.
+    void process (float* const* dry, int dryOffset, float* const* wet, int numChannels, int numSamples,
+                  const Stage& downwards, const Stage& upwards) noexcept;
+
+    int getLatencySamples() const noexcept { return fftSize; }
+
+    // Over the last frame, weighted by the bins' power: downwards reduction
+    // and upwards gain, positive dB
+    float getGainReductionDb() const noexcept { return gainReductionDb; }
+    float getUpwardsGainDb() const noexcept   { return upwardsGainDb; }
+
+    size_t getMemoryFootprintBytes() const noexcept;
+
+private:
+    static constexpr int paddedBins = (numBins + spectral::binAlignment - 1) / spectral::binAlignment * spectral::binAlignment;
+
+    const kernels::Table* dsp = kernels::getScalarTable();
+    RealFFT fft;
+
+    int numCh = 0;
+    int frameChannels = 1; // channels passed to the last process call
+    int maxBlock = 0;
+    int fill = 0; // samples of the current hop already taken in
+
+    // sqrt-Hann analysis window; the synthesis one includes the FFT's 1 / size
+    std::vector<float> analysisWindow, synthesisWindow;
+    float powerScale = 1.0f;
+
+    // Per channel: the last fftSize input samples (the newest hop still
+    // filling), the overlap-add accumulator, and the finished hop being played
+    ArenaView<float> inputFifo, outputAccum, outputReady;
+
+    // Per channel: dry delay line, latency samples then the current block
+    ArenaView<float> dryLines;
+
+    // One frame: time-domain scratch, per channel spectrum, and per bin
+    // power, detector level (mean square of its three-bin band), smoothed
+    // gains of both stages and the total gain
+    ArenaView<float> frame, spectrumRe, spectrumIm;
+    ArenaView<float> power, level, downGains, upGains, gains;
+
+    // Stage settings for the next frame (spectral::Setting order)
+    float settings[spectral::numSettings] {};
+
+    float gainReductionDb = 0.0f, upwardsGainDb = 0.0f;
+
+    void processFrame() noexcept;
+};
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+// Per-bin gain computer of the spectral mode, written against the vector
+// interface of BatchKernel.h and using its curve maths. Like it, include it
+// inside each level's target region (DSPKernels_*.cpp), after BatchKernel.h.
+
+namespace ultradyn
+{
+namespace spectral
+{
+//==============================================================================
+// Settings of both stages, in the terms CompressorStage uses (slope = 1 - 1 /
+// ratio, dry = (1 - mix) * stage gain, wet = mix * stage gain); attack and
+// release are one-pole coefficients per frame
+enum Setting
+{
+    threshold = 0, slope, halfKnee, invKnee, attack, release, dry, wet,
+    upThreshold, upSlope, upHalfKnee, upInvKnee, upAttack, upRelease, upDry, upWet,
+    numSettings
+};
+
+// Bins run in steps of the widest vector
+static constexpr int binAlignment = 16;
+
+// For each bin of one frame: the downwards curve on the bin's mean square,
+// attack/release on its linear gain, then the upwards stage on the
+// downwards stage's output. downGains and upGains are the smoothed gains
+// (state, carried from frame to frame); gains receives the gain of both
+// stages with their mix and output gain. numBins is a multiple of binAlignment.
+template <typename V>
+void binGains (const float* settings, const float* power, float* downGains, float* upGains,
+               float* gains, int numBins) noexcept
+{
+    using Reg = typename V::Reg;
+    using M = batch::Math<V>;
+
+    const Reg thr = V::set (settings[threshold]), slp = V::set (settings[slope]);
+    const Reg halfKn = V::set (settings[halfKnee]), invKn = V::set (settings[invKnee]);
+    const Reg att = V::set (settings[attack]), rel = V::set (settings[release]);
+    const Reg dryGain = V::set (settings[dry]), wetGain = V::set (settings[wet]);
+    const Reg uThr = V::set (settings[upThreshold]), uSlp = V::set (settings[upSlope]);
+    const Reg uHalfKn = V::set (settings[upHalfKnee]), uInvKn = V::set (settings[upInvKnee]);
+    const Reg uAtt = V::set (settings[upAttack]), uRel = V::set (settings[upRelease]);
+    const Reg uDryGain = V::set (settings[upDry]), uWetGain = V::set (settings[upWet]);
+
+    // Bins under -80 dB hold no signal worth lifting (near the -100 dB floor
+    // they would get the largest lift)
+    const Reg zero = V::set (0.0f), one = V::set (1.0f), silence = V::set (1.0e-8f);
+
+    for (int i = 0; i < numBins; i += V::width)
+    {
+        const Reg p = V::loadu (power + i);
+
+        // Downwards
+        Reg g = V::loadu (downGains + i);
+        const Reg target = M::dbToGain (V::sub (zero, M::curve (V::sub (M::meanSquareToDb (p), thr), slp, halfKn, invKn)));
+        g = V::madd (V::select (V::lt (target, g), att, rel), V::sub (g, target), target);
+        V::storeu (downGains + i, g);
+
+        const Reg down = V::madd (g, wetGain, dryGain);
+
+        // Upwards, detecting on the downwards output
+        const Reg up2 = V::mul (p, V::mul (down, down));
+        Reg ug = V::loadu (upGains + i);
+        const Reg lift = M::dbToGain (M::curve (V::sub (uThr, M::meanSquareToDb (up2)), uSlp, uHalfKn, uInvKn));
+        const Reg uTarget = V::select (V::gt (up2, silence), lift, one);
+        ug = V::madd (V::select (V::gt (uTarget, ug), uAtt, uRel), V::sub (ug, uTarget), uTarget);
+        V::storeu (upGains + i, ug);
+
+        V::storeu (gains + i, V::mul (down, V::madd (ug, uWetGain, uDryGain)));
+    }
+}
+}
+}
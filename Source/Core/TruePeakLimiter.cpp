@@ -0,0 +1,134 @@
+#include "TruePeakLimiter.h"
+#include "TruePeakKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace ultradyn
+{
+//==============================================================================
+void TruePeakLimiter::prepare (double sampleRate, int numChannels, int maxBlockSize, const kernels::Table& kernelTable,
+                               ScratchArena::Layout& scratch)
+{
+    dsp = &kernelTable;
+    maxBlock = std::max (1, maxBlockSize);
+
+    // 1.5 ms of lookahead ramps the gain down without audible distortion. The
+    // hold covers the detector's FIR span around each peak, so every sample
+    // that shapes an inter-sample peak gets the full reduction; the audio is
+    // delayed to line the middle of the hold up with the peak.
+    lookahead  = std::max (1, (int) std::lround (sampleRate * 0.0015));
+    holdWindow = lookahead + 2 * truepeak::delay;
+    latency    = lookahead + truepeak::numTaps - 1;
+
+    numLines = std::max (1, numChannels);
+    lineLength = (size_t) (latency + maxBlock);
+    scratch.reserve (delayStorage, (size_t) numLines * lineLength);
+    scratch.reserve (peak, (size_t) maxBlock);
+    scratch.reserve (minValues, (size_t) holdWindow);
+    scratch.reserve (minExpiry, (size_t) holdWindow);
+    scratch.reserve (boxRing, (size_t) lookahead);
+}
+
+void TruePeakLimiter::reset() noexcept
+{
+    std::fill (delayStorage.begin(), delayStorage.end(), 0.0f);
+    minHead = minSize = 0;
+    clock = 0;
+    released = 1.0f;
+    std::fill (boxRing.begin(), boxRing.end(), 1.0f);
+    boxPos = 0;
+    boxSum = (double) lookahead;
+}
+
+//==============================================================================
+void TruePeakLimiter::process (float* const* channels, int numChannels, int offset, int numSamples,
+                               float ceiling, float releaseCoeff, bool interSample) noexcept
+{
+    const int numCh = std::min (numChannels, numLines);
+    if (numCh <= 0)
+        return;
+
+    for (int start = 0; start < numSamples; start += maxBlock)
+    {
+        const int n = std::min (maxBlock, numSamples - start);
+
+        std::fill (peak.begin(), peak.begin() + n, 0.0f);
+        detect (channels, 0, numCh, offset + start, n, interSample, peak.data());
+        computeGain (peak.data(), n, ceiling, releaseCoeff);
+        apply (channels, 0, numCh, offset + start, n);
+    }
+}
+
+// Append the block to each delay line and take the loudest channel's true
+// peak per sample
+void TruePeakLimiter::detect (float* const* channels, int firstChannel, int lastChannel, int offset, int numSamples,
+                              bool interSample, float* peaks) noexcept
+{
+    for (int ch = firstChannel; ch < lastChannel; ++ch)
+    {
+        float* line = delayLine (ch);
+        std::memcpy (line + latency, channels[ch] + offset, (size_t) numSamples * sizeof (float));
+
+        const float* history = line + latency - (truepeak::numTaps - 1);
+        if (interSample)
+        {
+            dsp->truePeak (history, peaks, numSamples);
+        }
+        else
+        {
+            for (int i = 0; i < numSamples; ++i)
+                peaks[i] = std::max (peaks[i], std::abs (history[i + truepeak::delay - 1]));
+        }
+    }
+}
+
+// Required gain -> held minimum -> release -> box average, into peak
+void TruePeakLimiter::computeGain (const float* peaks, int numSamples, float ceiling, float releaseCoeff) noexcept
+{
+    const double boxScale = 1.0 / (double) lookahead;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float required = peaks[i] > ceiling ? ceiling / peaks[i] : 1.0f;
+
+        if (minSize > 0 && minExpiry[(size_t) minHead] == clock)
+        {
+            minHead = minHead + 1 < holdWindow ? minHead + 1 : 0;
+            --minSize;
+        }
+
+        while (minSize > 0 && minValues[(size_t) ((minHead + minSize - 1) % holdWindow)] >= required)
+            --minSize;
+
+        const auto back = (size_t) ((minHead + minSize) % holdWindow);
+        minValues[back] = required;
+        minExpiry[back] = clock + (unsigned) holdWindow;
+        ++minSize;
+        ++clock;
+
+        const float held = minValues[(size_t) minHead];
+        released = held < released ? held : held + (released - held) * releaseCoeff;
+
+        boxSum += (double) released - (double) boxRing[(size_t) boxPos];
+        boxRing[(size_t) boxPos] = released;
+        boxPos = boxPos + 1 < lookahead ? boxPos + 1 : 0;
+
+        peak[(size_t) i] = (float) (boxSum * boxScale);
+    }
+}
+
+void TruePeakLimiter::apply (float* const* channels, int firstChannel, int lastChannel, int offset, int numSamples) noexcept
+{
+    for (int ch = firstChannel; ch < lastChannel; ++ch)
+    {
+        float* line = delayLine (ch);
+        float* out = channels[ch] + offset;
+        for (int i = 0; i < numSamples; ++i)
+            out[i] = line[i] * peak[(size_t) i];
+
+        std::memmove (line, line + numSamples, (size_t) latency * sizeof (float));
+    }
+}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "DSPKernels.h"
+#include "ScratchArena.h"
+
+namespace ultradyn
+{
+//==============================================================================
+// Lookahead brickwall limiter on inter-sample peaks, the last stage of the
+// compressor. Only the detector is oversampled: a 4x polyphase estimate of the
+// true peak (TruePeakKernel.h) sets the required gain, which is held across the
+// lookahead, released with a one-pole curve and smoothed with a box filter of
+// the lookahead length, so it ramps down fully before the peak arrives.
+// Channels share one gain. Its buffers live in the owner's scratch arena.
+class TruePeakLimiter
+{
+public:
+    // Reserves the buffers in scratch; reset() once the arena is allocated
+    void prepare (double sampleRate, int numChannels, int maxBlockSize, const kernels::Table& dsp,
+                  ScratchArena::Layout& scratch);
+    void reset() noexcept;
+
+    // channels[ch][offset + i] in place; the output is the input delayed by
+    // getLatencySamples(). ceiling is linear, releaseCoeff a one-pole
+    // coefficient per sample. Without interSample the detector reads sample
+    // peaks only (cheaper; the latency is the same).
+    void process (float* const* channels, int numChannels, int offset, int numSamples,
+                  float ceiling, float releaseCoeff, bool interSample = true) noexcept;
+
+    // process() in three steps for up to maxBlockSize samples, so the channel
+    // loops can be split across threads: detect() appends channels
+    // [firstChannel, lastChannel) to their delay lines and raises peaks[i] to
+    // their loudest true peak, computeGain() runs the gain curve on the
+    // combined peaks, and apply() writes those channels' delayed output
+    void detect (float* const* channels, int firstChannel, int lastChannel, int offset, int numSamples,
+                 bool interSample, float* peaks) noexcept;
+    void computeGain (const float* peaks, int numSamples, float ceiling, float releaseCoeff) noexcept;
+    void apply (float* const* channels, int firstChannel, int lastChannel, int offset, int numSamples) noexcept;
+
+    int getLatencySamples() const noexcept { return latency; }
+
+private:
+    const kernels::Table* dsp = kernels::getScalarTable();
+
+    int lookahead = 1;     // ramp length, samples
+    int holdWindow = 1;    // lookahead plus the detector's span on either side
+    int latency = 0;
+    int maxBlock = 0;
+
+    // Per channel: the last latency input samples, then the current block. The
+    // detector reads its history from the same buffer.
+    ArenaView<float> delayStorage;
+    int numLines = 0;
+    size_t lineLength = 0;
+
+    float* delayLine (int ch) const noexcept { return delayStorage.data() + (size_t) ch * lineLength; }
+
+    // Per block: linked true peak, then the gain curve
+    ArenaView<float> peak;
+
+    // Sliding minimum of the required gain (monotonic queue in a ring)
+    ArenaView<float> minValues;
+    ArenaView<unsigned> minExpiry;
+    int minHead = 0, minSize = 0;
+    unsigned clock = 0;
+
+    // Released gain and the box filter's ring and running sum
+    float released = 1.0f;
+    ArenaView<float> boxRing;
+    int boxPos = 0;
+    double boxSum = 0.0;
+};
+}
@@ -0,0 +1,269 @@
+#include "UltraDynCore.h"
+#include "CompressorCore.h"
+#include "BatchCompressor.h"
+
+#include <cstring>
+#include <new>
+
+// The opaque handle is the C++ core itself
+struct ultradyn_compressor
+{
+    ultradyn::CompressorCore core;
+};
+
+struct ultradyn_batch
+{
+    ultradyn::BatchCompressor engine;
+};
+
+extern "C"
+{
+
+ultradyn_compressor* ultradyn_create (void)
+{
+    try
+    {
+        return new ultradyn_compressor();
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void ultradyn_destroy (ultradyn_compressor* c)
+{
+    delete c;
+}
+
+int ultradyn_prepare (ultradyn_compressor* c, double sampleRate, int numChannels)
+{
+    if (c == nullptr || ! (sampleRate > 0.0) || numChannels <= 0)
+        return -1;
+
+    try
+    {
+        c->core.prepare (sampleRate, numChannels);
+        return 0;
+    }
+    catch (...)
+    {
+        return -1;
+    }
+}
+
+void ultradyn_reset (ultradyn_compressor* c)
+{
+    if (c != nullptr)
+        c->core.reset();
+}
+
+void ultradyn_set_param (ultradyn_compressor* c, int param, float value)
+{
+    if (c != nullptr)
+        c->core.setParameter (param, value);
+}
+
+float ultradyn_get_param (const ultradyn_compressor* c, int param)
+{
+    return c != nullptr ? c->core.getParameter (param) : 0.0f;
+}
+
+const char* ultradyn_param_id (int param)
+{
+    const auto* info = ultradyn::CompressorCore::getParameterInfo (param);
+    return info != nullptr ? info->id : nullptr;
+}
+
+void ultradyn_param_range (int param, float* minValue, float* maxValue)
+{
+    const auto* info = ultradyn::CompressorCore::getParameterInfo (param);
+    if (minValue != nullptr) *minValue = info != nullptr ? info->minValue : 0.0f;
+    if (maxValue != nullptr) *maxValue = info != nullptr ? info->maxValue : 0.0f;
+}
+
+float ultradyn_param_default (int param)
+{
+    const auto* info = ultradyn::CompressorCore::getParameterInfo (param);
+    return info != nullptr ? info->defaultValue : 0.0f;
+}
+
+int ultradyn_param_index (const char* id)
+{
+    if (id == nullptr)
+        return -1;
+
+    for (int i = 0; i < ULTRADYN_NUM_PARAMS; ++i)
+        if (std::strcmp (ultradyn::CompressorCore::getParameterInfo (i)->id, id) == 0)
+            return i;
+
+    return -1;
+}
+
+void ultradyn_process (ultradyn_compressor* c, float* const* channels, int numChannels, int numSamples)
+{
+    if (c != nullptr && channels != nullptr && numChannels > 0 && numSamples > 0)
+        c->core.process (channels, numChannels, numSamples);
+}
+
+void ultradyn_get_meters (const ultradyn_compressor* c, ultradyn_meters* out)
+{
+    if (c != nullptr && out != nullptr)
+        *out = c->core.getMeters();
+}
+
+int ultradyn_latency_samples (const ultradyn_compressor* c)
+{
+    return c != nullptr ? c->core.getLatencySamples() : 0;
+}
+
+int ultradyn_quality_tier (const ultradyn_compressor* c)
+{
+    return c != nullptr ? c->core.getQualityTier() : 0;
+}
+
+void ultradyn_set_non_realtime (ultradyn_compressor* c, int nonRealtime)
+{
+    if (c != nullptr)
+        c->core.setNonRealtime (nonRealtime != 0);
+}
+
+int ultradyn_update_link (ultradyn_compressor* c)
+{
+    return c != nullptr && c->core.updateLink() ? 0 : -1;
+}
+
+int ultradyn_update_channel_threads (ultradyn_compressor* c)
+{
+    return c != nullptr ? c->core.updateChannelThreads() : 0;
+}
+
+unsigned long long ultradyn_get_histogram (const ultradyn_compressor* c, int stage,
+                                           unsigned int counts[ULTRADYN_HISTOGRAM_BINS])
+{
+    if (c == nullptr || counts == nullptr || stage < 0 || stage > 1)
+        return 0;
+
+    uint32_t copy[ULTRADYN_HISTOGRAM_BINS];
+    const uint64_t total = c->core.readHistogram (stage, copy);
+    for (int b = 0; b < ULTRADYN_HISTOGRAM_BINS; ++b)
+        counts[b] = copy[b];
+    return total;
+}
+
+void ultradyn_reset_histograms (ultradyn_compressor* c)
+{
+    if (c != nullptr)
+        c->core.resetHistograms();
+}
+
+float ultradyn_suggest_threshold (const ultradyn_compressor* c, int stage, float percentOfTime)
+{
+    return c != nullptr && stage >= 0 && stage <= 1 ? c->core.suggestThreshold (stage, percentOfTime) : 0.0f;
+}
+
+float ultradyn_suggest_threshold_for_gain (const ultradyn_compressor* c, int stage, float averageDb)
+{
+    return c != nullptr && stage >= 0 && stage <= 1 ? c->core.suggestThresholdForGain (stage, averageDb) : 0.0f;
+}
+
+void ultradyn_set_analyzer_enabled (ultradyn_compressor* c, int enabled)
+{
+    if (c == nullptr)
+        return;
+
+    try
+    {
+        c->core.setAnalyzerEnabled (enabled != 0);
+    }
+    catch (...)
+    {
+    }
+}
+
+int ultradyn_read_analyzer (ultradyn_compressor* c, float* detector, float* output, int maxSamples)
+{
+    if (c == nullptr || detector == nullptr || output == nullptr)
+        return 0;
+
+    return c->core.readAnalyzer (detector, output, maxSamples);
+}
+
+unsigned long ultradyn_memory_footprint (const ultradyn_compressor* c)
+{
+    return c != nullptr ? (unsigned long) c->core.getMemoryFootprintBytes() : 0ul;
+}
+
+unsigned long ultradyn_scratch_bytes (const ultradyn_compressor* c)
+{
+    return c != nullptr ? (unsigned long) c->core.getScratchBytes() : 0ul;
+}
+
+//==============================================================================
+ultradyn_batch* ultradyn_batch_create (void)
+{
+    try
+    {
+        return new ultradyn_batch();
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void ultradyn_batch_destroy (ultradyn_batch* b)
+{
+    delete b;
+}
+
+int ultradyn_batch_prepare (ultradyn_batch* b, double sampleRate, int numStreams)
+{
+    if (b == nullptr || ! (sampleRate > 0.0) || numStreams <= 0)
+        return -1;
+
+    try
+    {
+        b->engine.prepare (sampleRate, numStreams);
+        return 0;
+    }
+    catch (...)
+    {
+        return -1;
+    }
+}
+
+void ultradyn_batch_reset (ultradyn_batch* b)
+{
+    if (b != nullptr)
+        b->engine.reset();
+}
+
+void ultradyn_batch_set_param (ultradyn_batch* b, int stream, int param, float value)
+{
+    if (b != nullptr)
+        b->engine.setParameter (stream, param, value);
+}
+
+float ultradyn_batch_get_param (const ultradyn_batch* b, int stream, int param)
+{
+    return b != nullptr ? b->engine.getParameter (stream, param) : 0.0f;
+}
+
+void ultradyn_batch_process (ultradyn_batch* b, float* const* streams, int numSamples)
+{
+    if (b != nullptr && streams != nullptr && numSamples > 0)
+        b->engine.process (streams, numSamples);
+}
+
+float ultradyn_batch_gain_reduction (const ultradyn_batch* b, int stream)
+{
+    return b != nullptr ? b->engine.getGainReductionDb (stream) : 0.0f;
+}
+
+float ultradyn_batch_upwards_gain (const ultradyn_batch* b, int stream)
+{
+    return b != nullptr ? b->engine.getUpwardsGainDb (stream) : 0.0f;
+}
+
+}
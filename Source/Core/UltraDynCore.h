@@ -0,0 +1,260 @@
+#ifndef ULTRADYN_CORE_H
+#define ULTRADYN_CORE_H
+
+/*
+    ultraDYN DSP core: the complete compressor (detectors, gain computers,
+    sidechain EQ, stage ordering and mixing) without JUCE.
+
+    The plugin is a thin wrapper around this API; servers and test rigs can
+    link libultraDYNCore directly. All functions taking an instance are safe to
+    call from one audio thread at a time; ultradyn_set_param and
+    ultradyn_get_meters may be called from any thread concurrently with
+    ultradyn_process.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ultradyn_compressor ultradyn_compressor;
+
+/* Parameter indices; values are in the same units as the plugin parameters */
+typedef enum ultradyn_param
+{
+    ULTRADYN_PARAM_INPUT_GAIN = 0,      /* dB, -24..24 */
+    ULTRADYN_PARAM_OUTPUT_GAIN,         /* dB, -24..24 */
+    ULTRADYN_PARAM_GLOBAL_MIX,          /* %, 0..100 */
+    ULTRADYN_PARAM_THRESHOLD,           /* dB, -60..0 */
+    ULTRADYN_PARAM_RATIO,               /* 1..20 */
+    ULTRADYN_PARAM_ATTACK,              /* ms, 0.1..100 */
+    ULTRADYN_PARAM_RELEASE,             /* ms, 5..1000 */
+    ULTRADYN_PARAM_KNEE,                /* dB, 0..24 */
+    ULTRADYN_PARAM_MIX,                 /* %, 0..100 */
+    ULTRADYN_PARAM_DOWNWARDS_OUTPUT,    /* dB, -24..24 */
+    ULTRADYN_PARAM_DOWNWARDS_BYPASS,    /* 0/1 */
+    ULTRADYN_PARAM_VOCAL_MODE,          /* 0/1 */
+    ULTRADYN_PARAM_DRUMBUS_MODE,        /* 0/1 */
+    ULTRADYN_PARAM_SC_HPF_FREQ,         /* Hz, 20..1000 (20 = off) */
+    ULTRADYN_PARAM_SC_LOW_SHELF_FREQ,   /* Hz, 40..1000 */
+    ULTRADYN_PARAM_SC_LOW_SHELF_GAIN,   /* dB, -12..12 */
+    ULTRADYN_PARAM_SC_PEAK_FREQ,        /* Hz, 200..10000 */
+    ULTRADYN_PARAM_SC_PEAK_GAIN,        /* dB, -12..12 */
+    ULTRADYN_PARAM_SC_PEAK_Q,           /* 0.3..6 */
+    ULTRADYN_PARAM_SC_HIGH_SHELF_FREQ,  /* Hz, 1000..16000 */
+    ULTRADYN_PARAM_SC_HIGH_SHELF_GAIN,  /* dB, -12..12 */
+    ULTRADYN_PARAM_UPWARDS_THRESHOLD,   /* dB, -60..0 */
+    ULTRADYN_PARAM_UPWARDS_RATIO,       /* 1..10 */
+    ULTRADYN_PARAM_UPWARDS_ATTACK,      /* ms, 0.1..100 */
+    ULTRADYN_PARAM_UPWARDS_RELEASE,     /* ms, 5..1000 */
+    ULTRADYN_PARAM_UPWARDS_KNEE,        /* dB, 0..24 */
+    ULTRADYN_PARAM_UPWARDS_MIX,         /* %, 0..100 */
+    ULTRADYN_PARAM_UPWARDS_OUTPUT,      /* dB, -24..24 */
+    ULTRADYN_PARAM_UPWARDS_BYPASS,      /* 0/1 */
+    ULTRADYN_PARAM_UPWARDS_FIRST,       /* 0/1 */
+    ULTRADYN_PARAM_CONTROL_RATE,        /* 0/1 */
+    ULTRADYN_PARAM_TRUE_PEAK_LIMITER,   /* 0/1 */
+    ULTRADYN_PARAM_LIMITER_CEILING,     /* dBTP, -12..0 */
+    ULTRADYN_PARAM_LIMITER_RELEASE,     /* ms, 10..1000 */
+    ULTRADYN_PARAM_AUTO_QUALITY,        /* 0/1 */
+    ULTRADYN_PARAM_CPU_BUDGET,          /* % of the block duration, 1..50 */
+    ULTRADYN_PARAM_LINK_GROUP,          /* 0..16 (0 = not linked), see ultradyn_update_link */
+    ULTRADYN_PARAM_LINK_MODE,           /* 0 = loudest member, 1 = sum of members */
+    ULTRADYN_PARAM_SPECTRAL_MODE,       /* 0/1, see ultradyn_latency_samples */
+    ULTRADYN_PARAM_RENDER_PROFILE,      /* 0 = as live, 1 = best quality; see ultradyn_set_non_realtime */
+    ULTRADYN_PARAM_CHANNEL_THREADS,     /* 0 = off, 1 = offline only, 2 = always; see ultradyn_update_channel_threads */
+    ULTRADYN_PARAM_STAGE2_PARALLEL,     /* 0/1: a branch beside the first stage, see the stage chain below */
+    ULTRADYN_PARAM_STAGE3_TYPE,         /* 0 = off, 1 = downwards, 2 = upwards, 3 = limiter */
+    ULTRADYN_PARAM_STAGE3_PARALLEL,     /* 0/1: a branch beside the stage before */
+    ULTRADYN_PARAM_STAGE3_THRESHOLD,    /* dB, -60..0 */
+    ULTRADYN_PARAM_STAGE3_RATIO,        /* 1..20 (not used by the limiter) */
+    ULTRADYN_PARAM_STAGE3_ATTACK,       /* ms, 0.1..100 (not used by the limiter) */
+    ULTRADYN_PARAM_STAGE3_RELEASE,      /* ms, 5..1000 */
+    ULTRADYN_PARAM_STAGE3_KNEE,         /* dB, 0..24 (not used by the limiter) */
+    ULTRADYN_PARAM_STAGE3_MIX,          /* %, 0..100 */
+    ULTRADYN_PARAM_STAGE3_OUTPUT,       /* dB, -24..24 */
+    ULTRADYN_PARAM_STAGE4_TYPE,         /* as STAGE3 */
+    ULTRADYN_PARAM_STAGE4_PARALLEL,
+    ULTRADYN_PARAM_STAGE4_THRESHOLD,
+    ULTRADYN_PARAM_STAGE4_RATIO,
+    ULTRADYN_PARAM_STAGE4_ATTACK,
+    ULTRADYN_PARAM_STAGE4_RELEASE,
+    ULTRADYN_PARAM_STAGE4_KNEE,
+    ULTRADYN_PARAM_STAGE4_MIX,
+    ULTRADYN_PARAM_STAGE4_OUTPUT,
+    ULTRADYN_NUM_PARAMS
+} ultradyn_param;
+
+/* Stage chain. The downwards and upwards stages (in the order UPWARDS_FIRST
+   picks) can be followed by two more, STAGE3 and STAGE4, each a downwards,
+   upwards or limiter stage (the limiter holds the loudest channel's sample
+   peaks at its threshold with instant attack and no lookahead; the true-peak
+   limiter stays the final stage) with its own threshold, time constants,
+   mix and output gain. Each stage after the first runs in series, on the
+   output of the stages before it, or with its PARALLEL flag on as a branch
+   beside the stage before it: the branches process (and detect on) the same
+   input and their outputs are averaged, so two identical branches sound like
+   one. The stages share one mono sidechain sum, one copy of
+   the dry signal and the scratch arena, so a stage costs a detector and a
+   gain pass rather than a whole instance. Spectral mode runs only the
+   downwards and upwards stages. */
+#define ULTRADYN_MAX_STAGES 4
+
+typedef struct ultradyn_meters
+{
+    float gainReductionDb;  /* reduction of the downwards and limiter stages, positive dB */
+    float upwardsGainDb;    /* gain of the upwards stages, positive dB */
+    float inputLevelDb;     /* peak after input gain, -60 floor */
+    float outputLevelDb;    /* peak after output gain, -60 floor */
+} ultradyn_meters;
+
+/* Lifetime. create returns NULL on allocation failure. */
+ultradyn_compressor* ultradyn_create (void);
+void ultradyn_destroy (ultradyn_compressor* c);
+
+/* Allocates and resets everything for a sample rate and channel count.
+   Any block length can be processed afterwards. Returns 0 on success. */
+int ultradyn_prepare (ultradyn_compressor* c, double sampleRate, int numChannels);
+
+/* Clears detector and filter state, keeping parameters */
+void ultradyn_reset (ultradyn_compressor* c);
+
+/* Parameters. Out-of-range indices are ignored / return 0. */
+void ultradyn_set_param (ultradyn_compressor* c, int param, float value);
+float ultradyn_get_param (const ultradyn_compressor* c, int param);
+
+/* Parameter metadata: the plugin's parameter ID (e.g. "THRESHOLD"), range
+   and default value, and the index for an ID (-1 if unknown). Values passed
+   to ultradyn_set_param are clamped to the range. */
+const char* ultradyn_param_id (int param);
+void ultradyn_param_range (int param, float* minValue, float* maxValue);
+float ultradyn_param_default (int param);
+int ultradyn_param_index (const char* id);
+
+/* Processes planar float channels in place. numChannels may be lower than
+   the prepared count; extra channels beyond it are left untouched. */
+void ultradyn_process (ultradyn_compressor* c, float* const* channels, int numChannels, int numSamples);
+
+void ultradyn_get_meters (const ultradyn_compressor* c, ultradyn_meters* out);
+
+/* Delay the processor adds, in samples: the true-peak limiter's lookahead
+   while it is on, plus 1024 in spectral mode. Changes when TRUE_PEAK_LIMITER
+   or SPECTRAL_MODE is toggled.
+
+   SPECTRAL_MODE applies both stages per frequency bin (1024-point FFT, 50%
+   overlap) rather than to the whole signal, with the same stage parameters.
+   The stages always run downwards then upwards, and the sidechain EQ and the
+   detector link are not used. */
+int ultradyn_latency_samples (const ultradyn_compressor* c);
+
+/* Engine tier in use. With AUTO_QUALITY on, the processor times its own
+   process calls; while they take more than CPU_BUDGET of the block duration
+   it steps down a tier, and steps back up once there has been ample
+   headroom for two seconds. Transitions are click-free.
+     0: as configured
+     1: control-rate gain computers (as CONTROL_RATE)
+     2: also sample-peak limiter detection, and the later stages detect on
+        the first stage's sidechain instead of filtering their own */
+#define ULTRADYN_NUM_QUALITY_TIERS 3
+int ultradyn_quality_tier (const ultradyn_compressor* c);
+
+/* Marks offline rendering (a host bounce), where processing time does not
+   matter. With RENDER_PROFILE 1 the processor then runs its best engine:
+   per-sample gain computers whatever CONTROL_RATE says, and tier 0 whatever
+   AUTO_QUALITY would pick. Switching either way is click-free and keeps all
+   detector state. May be called from any thread, e.g. before each block. */
+void ultradyn_set_non_realtime (ultradyn_compressor* c, int nonRealtime);
+
+/* Detector link. Instances with the same LINK_GROUP, in this process or any
+   other of the same user, share their downwards detector level: each one
+   compresses on the louder of its own level and the loudest other member's
+   (LINK_MODE 0), or on the sum of all members' levels (LINK_MODE 1), as
+   published in the previous process call. Linking is lock-free and costs the
+   same for any group size. Joining a group allocates, so LINK_GROUP only takes
+   effect here (and in ultradyn_prepare); call it off the audio thread after
+   changing the parameter. Returns 0 on success, -1 if the group could not be
+   joined. */
+int ultradyn_update_link (ultradyn_compressor* c);
+
+/* Channel threads, for wide buses (16 channels and more). The per-channel
+   work of each sub-block (gains, mix, limiter detection and output) is split
+   into channel groups, one per worker thread plus one on the calling thread,
+   which waits for all of them before returning; the detector still runs once,
+   on the calling thread. The output is identical to processing on one
+   thread. With CHANNEL_THREADS 1 the workers are only used while
+   ultradyn_set_non_realtime is set, with 2 also live, and only for calls of
+   128 samples or more. Up to 3 workers (one per 8 channels beyond the first
+   8, and fewer than the CPU has cores); between calls they spin for 100 us,
+   then sleep, and are woken without blocking. Starting the threads
+   allocates, so CHANNEL_THREADS only takes effect here (and in
+   ultradyn_prepare); call it off the audio thread after changing the
+   parameter. Once started the workers stay until the next ultradyn_prepare.
+   Returns the number of workers running. */
+int ultradyn_update_channel_threads (ultradyn_compressor* c);
+
+/* Level histograms of the stages' detectors (stage 0 downwards, 1 upwards;
+   STAGE3 and STAGE4 are not counted): how often each RMS level in 1 dB
+   bins, bin b covering MIN_DB + b to MIN_DB + b + 1 (the ends also count
+   everything beyond them), was seen over roughly the last minute of
+   processing. Counting costs about a nanosecond per
+   sample on the audio thread. get_histogram copies the snapshot published
+   every 100 ms, from any thread, and returns the total count. A stage only
+   counts while its detector runs (not bypassed, not in spectral mode). */
+#define ULTRADYN_HISTOGRAM_BINS 96
+#define ULTRADYN_HISTOGRAM_MIN_DB (-90)
+unsigned long long ultradyn_get_histogram (const ultradyn_compressor* c, int stage,
+                                           unsigned int counts[ULTRADYN_HISTOGRAM_BINS]);
+void ultradyn_reset_histograms (ultradyn_compressor* c);
+
+/* Threshold suggestions from the histograms, within the parameter's range;
+   the current threshold while nothing has been counted. suggest_threshold:
+   the threshold the level is over (downwards) or under (upwards) for
+   percentOfTime of the time. suggest_threshold_for_gain: the threshold at
+   which the stage's static curve, with its current ratio and knee, would
+   average averageDb of reduction or lift. */
+float ultradyn_suggest_threshold (const ultradyn_compressor* c, int stage, float percentOfTime);
+float ultradyn_suggest_threshold_for_gain (const ultradyn_compressor* c, int stage, float averageDb);
+
+/* Signals for a spectrum analyzer: the first stage's detector signal after
+   the sidechain EQ (the unfiltered input in spectral mode) and the mono sum
+   of the output. While enabled, the audio thread copies each sub-block into
+   a lock-free ring of about 16k samples and drops it if the ring is full;
+   while disabled (the default) it does nothing. Enabling allocates the ring
+   the first time. One reader thread at a time may enable, disable and read;
+   read_analyzer copies out up to maxSamples of each, oldest first, and
+   returns how many. */
+void ultradyn_set_analyzer_enabled (ultradyn_compressor* c, int enabled);
+int ultradyn_read_analyzer (ultradyn_compressor* c, float* detector, float* output, int maxSamples);
+
+/* Approximate bytes owned by the instance (shared tables split across users) */
+unsigned long ultradyn_memory_footprint (const ultradyn_compressor* c);
+
+/* Of those, the scratch arena: one 64-byte aligned block, sized in
+   ultradyn_prepare from the sample rate and channel count, holding every
+   buffer processing uses (sub-block scratch, the limiter's delay lines, the
+   spectral mode's frames). Processing allocates nothing else. */
+unsigned long ultradyn_scratch_bytes (const ultradyn_compressor* c);
+
+/* Multi-stream engine: many independent mono streams, one per SIMD lane,
+   each with its own parameters (see BatchCompressor.h for how it differs
+   from the single-instance processor). stream -1 in set_param sets all. */
+typedef struct ultradyn_batch ultradyn_batch;
+
+ultradyn_batch* ultradyn_batch_create (void);
+void ultradyn_batch_destroy (ultradyn_batch* b);
+int ultradyn_batch_prepare (ultradyn_batch* b, double sampleRate, int numStreams);
+void ultradyn_batch_reset (ultradyn_batch* b);
+void ultradyn_batch_set_param (ultradyn_batch* b, int stream, int param, float value);
+float ultradyn_batch_get_param (const ultradyn_batch* b, int stream, int param);
+
+/* One buffer of numSamples per prepared stream, processed in place */
+void ultradyn_batch_process (ultradyn_batch* b, float* const* streams, int numSamples);
+
+/* Current downwards reduction / upwards gain of a stream, positive dB */
+float ultradyn_batch_gain_reduction (const ultradyn_batch* b, int stream);
+float ultradyn_batch_upwards_gain (const ultradyn_batch* b, int stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
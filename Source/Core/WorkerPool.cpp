@@ -0,0 +1,142 @@
+#include "WorkerPool.h"
+#include "DSPKernels.h"
+
+#include <chrono>
+
+namespace ultradyn
+{
+//==============================================================================
+namespace
+{
+    // How long an idle worker polls for the next job before parking: covers
+    // the serial detector work between the parallel parts of a sub-block, and
+    // back-to-back blocks of an offline render
+    constexpr auto spinTime = std::chrono::microseconds (100);
+
+    inline void cpuRelax() noexcept
+    {
+       #if ULTRADYN_KERNELS_X86
+        _mm_pause();
+       #elif ULTRADYN_KERNELS_NEON && defined (__aarch64__)
+        asm volatile ("yield");
+       #endif
+    }
+}
+
+void WorkerPool::start (int numWorkers)
+{
+    stop();
+    if (numWorkers <= 0)
+        return;
+
+    quit.store (false);
+    const uint32_t seen = generation.load();
+
+    // Runs with as many as the system lets us create
+    try
+    {
+        for (int i = 0; i < numWorkers; ++i)
+            threads.emplace_back ([this, i, seen] { workerLoop (i + 1, seen); });
+    }
+    catch (...) {}
+
+    numRunning.store ((int) threads.size(), std::memory_order_release);
+}
+
+void WorkerPool::stop()
+{
+    if (threads.empty())
+        return;
+
+    numRunning.store (0, std::memory_order_release);
+    quit.store (true);
+    {
+        const std::lock_guard<std::mutex> sl (parkLock);
+    }
+    wakeUp.notify_all();
+
+    for (auto& t : threads)
+        t.join();
+
+    threads.clear();
+}
+
+//==============================================================================
+void WorkerPool::runTasks (TaskFunction function, void* context) noexcept
+{
+    const int numWorkers = numRunning.load (std::memory_order_relaxed);
+
+    jobFunction = function;
+    jobContext = context;
+    pending.store (numWorkers, std::memory_order_relaxed);
+    generation.fetch_add (1); // publishes the job
+
+    bool wakePending = numParked.load() > 0 && ! wakeParked();
+
+    function (context, 0);
+
+    while (pending.load (std::memory_order_acquire) > 0)
+    {
+        if (wakePending)
+            wakePending = ! wakeParked();
+
+        cpuRelax();
+    }
+}
+
+bool WorkerPool::wakeParked() noexcept
+{
+    // A worker counts itself parked before it checks the generation under the
+    // lock, so if we get the lock after publishing, either it sees the new job
+    // or it is waiting when we notify. Never blocks: while a worker holds the
+    // lock it is about to wait or just waking, and the caller tries again.
+    if (! parkLock.try_lock())
+        return false;
+
+    parkLock.unlock();
+    wakeUp.notify_all();
+    return true;
+}
+
+void WorkerPool::workerLoop (int task, uint32_t seen)
+{
+    // Same floating-point mode as the process call the tasks come from
+    kernels::ScopedFlushDenormals noDenormals;
+
+    using Clock = std::chrono::steady_clock;
+
+    for (;;)
+    {
+        // Spin, checking the clock every few dozen polls, then park
+        bool ready = false;
+        const auto until = Clock::now() + spinTime;
+        do
+        {
+            for (int i = 0; i < 32 && ! ready; ++i)
+            {
+                ready = generation.load (std::memory_order_acquire) != seen || quit.load (std::memory_order_relaxed);
+                if (! ready)
+                    cpuRelax();
+            }
+        }
+        while (! ready && Clock::now() < until);
+
+        if (! ready)
+        {
+            numParked.fetch_add (1);
+            {
+                std::unique_lock<std::mutex> sl (parkLock);
+                wakeUp.wait (sl, [this, seen] { return generation.load() != seen || quit.load(); });
+            }
+            numParked.fetch_sub (1);
+        }
+
+        if (quit.load())
+            return;
+
+        seen = generation.load (std::memory_order_acquire);
+        jobFunction (jobContext, task);
+        pending.fetch_sub (1, std::memory_order_release);
+    }
+}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ultradyn
+{
+//==============================================================================
+// A few persistent threads that share one job with the calling thread. run()
+// hands tasks 1..n to the workers, runs task 0 itself and spins until every
+// task is done, so the join is complete when it returns. After a task the
+// workers spin for the next job (the next sub-block follows within
+// microseconds) and then park; the caller wakes parked workers once per burst
+// of jobs, with a try-lock, so run() never blocks on them.
+//
+// start() and stop() create and join the threads: not for the audio thread,
+// and not while run() may be called. run() belongs to one thread at a time.
+class WorkerPool
+{
+public:
+    WorkerPool() = default;
+    ~WorkerPool() { stop(); }
+
+    // Creates up to numWorkers threads (fewer if the system refuses more)
+    void start (int numWorkers);
+    void stop();
+
+    // Threads besides the caller; 0 while stopped
+    int getNumWorkers() const noexcept { return numRunning.load (std::memory_order_acquire); }
+
+    // Calls job (task) for every task from 0 to getNumWorkers(), task 0 on
+    // this thread, and returns when all have finished
+    template <typename Job>
+    void run (Job& job) noexcept
+    {
+        runTasks ([] (void* context, int task) { (*static_cast<Job*> (context)) (task); }, &job);
+    }
+
+private:
+    using TaskFunction = void (*) (void* context, int task);
+
+    void runTasks (TaskFunction function, void* context) noexcept;
+    bool wakeParked() noexcept;
+    void workerLoop (int task, uint32_t seen);
+
+    std::vector<std::thread> threads;
+    std::atomic<int> numRunning { 0 };
+
+    // The current job, published by bumping the generation; pending counts
+    // the workers' tasks still running
+    TaskFunction jobFunction = nullptr;
+    void* jobContext = nullptr;
+    alignas (64) std::atomic<uint32_t> generation { 0 };
+    alignas (64) std::atomic<int> pending { 0 };
+    std::atomic<int> numParked { 0 };
+    std::atomic<bool> quit { false };
+
+    std::mutex parkLock;
+    std::condition_variable wakeUp;
+
+    WorkerPool (const WorkerPool&) = delete;
+    WorkerPool& operator= (const WorkerPool&) = delete;
+};
+}
@@ -7,10 +7,8 @@
 #endif
 
 CompressorPluginAudioProcessorEditor::CompressorPluginAudioProcessorEditor (CompressorPluginAudioProcessor& p)
-    : AudioProcessorEditor (&p), processor (p)
+    : AudioProcessorEditor (&p), processor (p), spectrumView (p.getSpectrumAnalyzer())
 {
-    auto& apvts = processor.getAPVTS();
-
     // Setup header controls
     setupSlider (inputGainSlider,  "Input");
     setupSlider (outputGainSlider, "Output");
@@ -79,6 +77,11 @@ CompressorPluginAudioProcessorEditor::CompressorPluginAudioProcessorEditor (Comp
     upwardsFirstButton.setColour(juce::ToggleButton::tickColourId, juce::Colours::skyblue);
     this->addAndMakeVisible(upwardsFirstButton);
 
+    // Thresholds from what the detectors have seen so far
+    suggestThresholdsButton.setButtonText ("Suggest Thresholds");
+    suggestThresholdsButton.onClick = [this]() { processor.applySuggestedThresholds(); };
+    this->addAndMakeVisible(suggestThresholdsButton);
+
     // Add all sliders and labels to the UI
     this->addAndMakeVisible(inputGainSlider);
     this->addAndMakeVisible(outputGainSlider);
@@ -120,6 +123,7 @@ CompressorPluginAudioProcessorEditor::CompressorPluginAudioProcessorEditor (Comp
     this->addAndMakeVisible (inputMeter);
     this->addAndMakeVisible (outputMeter);
     this->addAndMakeVisible (upwardsMeter);
+    this->addAndMakeVisible (spectrumView);
     
     // Setup meter labels
     setupLabel(inputMeterLabel, "INPUT");
@@ -142,6 +146,51 @@ CompressorPluginAudioProcessorEditor::CompressorPluginAudioProcessorEditor (Comp
     upwardsBypassButton.setColour(juce::ToggleButton::tickDisabledColourId, juce::Colours::grey);
     this->addAndMakeVisible(upwardsBypassButton);
     
+    this->addAndMakeVisible(inputMeterLabel);
+    this->addAndMakeVisible(outputMeterLabel);
+    this->addAndMakeVisible(grMeterLabel);
+    this->addAndMakeVisible(upwardsMeterLabel);
+    this->addAndMakeVisible(downwardsSectionLabel);
+    this->addAndMakeVisible(upwardsSectionLabel);
+
+    setOpaque (true);
+    setResizable (false, false); // Disable resizing
+    setSize (800, 850 + analyzerHeight); // Fixed size: the controls layout plus the analyzer strip
+
+    // Setup bypass button click handlers
+    downwardsBypassButton.onClick = [this]() {
+        bool currentState = downwardsBypassValue.getValue();
+        downwardsBypassValue.setValue(!currentState);
+    };
+    
+    upwardsBypassButton.onClick = [this]() {
+        bool currentState = upwardsBypassValue.getValue();
+        upwardsBypassValue.setValue(!currentState);
+    };
+}
+
+//==============================================================================
+// Hosts may construct editors they never show; parameter attachments, bypass
+// listeners and the meter timer are only set up once the editor is on screen
+void CompressorPluginAudioProcessorEditor::visibilityChanged()
+{
+    if (isShowing())
+        attachToParameters();
+}
+
+void CompressorPluginAudioProcessorEditor::parentHierarchyChanged()
+{
+    if (isShowing())
+        attachToParameters();
+}
+
+void CompressorPluginAudioProcessorEditor::attachToParameters()
+{
+    if (inputGainAttachment != nullptr)
+        return;
+
+    auto& apvts = processor.getAPVTS();
+
     // Setup custom bypass value listeners
     downwardsBypassValue.addListener(this);
     upwardsBypassValue.addListener(this);
@@ -156,13 +205,6 @@ CompressorPluginAudioProcessorEditor::CompressorPluginAudioProcessorEditor (Comp
     downwardsBypassButton.setToggleState(!downwardsBypassed, juce::dontSendNotification);
     upwardsBypassButton.setToggleState(!upwardsBypassed, juce::dontSendNotification);
     
-    this->addAndMakeVisible(inputMeterLabel);
-    this->addAndMakeVisible(outputMeterLabel);
-    this->addAndMakeVisible(grMeterLabel);
-    this->addAndMakeVisible(upwardsMeterLabel);
-    this->addAndMakeVisible(downwardsSectionLabel);
-    this->addAndMakeVisible(upwardsSectionLabel);
-
     // Attachments for downwards compressor
     inputGainAttachment.reset (new juce::AudioProcessorValueTreeState::SliderAttachment (apvts, "INPUT_GAIN", inputGainSlider));
     outputGainAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment (apvts, "OUTPUT_GAIN", outputGainSlider));
@@ -187,26 +229,16 @@ CompressorPluginAudioProcessorEditor::CompressorPluginAudioProcessorEditor (Comp
     upwardsOutputAttachment.reset    (new juce::AudioProcessorValueTreeState::SliderAttachment (apvts, "UPWARDS_OUTPUT", upwardsOutputSlider));
     upwardsFirstAttachment.reset     (new juce::AudioProcessorValueTreeState::ButtonAttachment (apvts, "UPWARDS_FIRST", upwardsFirstButton));
 
-    setResizable (false, false); // Disable resizing
-    setSize (800, 850); // Fixed size matching the desired larger layout
+    // The analyzer thread only runs while an editor is on screen
+    spectrumView.setActive (true);
 
     startTimerHz (60);
-    
-    // Setup bypass button click handlers
-    downwardsBypassButton.onClick = [this]() {
-        bool currentState = downwardsBypassValue.getValue();
-        downwardsBypassValue.setValue(!currentState);
-    };
-    
-    upwardsBypassButton.onClick = [this]() {
-        bool currentState = upwardsBypassValue.getValue();
-        upwardsBypassValue.setValue(!currentState);
-    };
 }
 
 CompressorPluginAudioProcessorEditor::~CompressorPluginAudioProcessorEditor()
 {
     stopTimer();
+    spectrumView.setActive (false);
     downwardsBypassValue.removeListener(this);
     upwardsBypassValue.removeListener(this);
 }
@@ -227,6 +259,18 @@ void CompressorPluginAudioProcessorEditor::valueChanged(juce::Value& value)
 }
 
 void CompressorPluginAudioProcessorEditor::paint (juce::Graphics& g)
+{
+    // Some hosts show the window without notifying the editor; the first
+    // paint comes before the children's, so controls still paint attached
+    attachToParameters();
+
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    g.drawImage (artCache->get (StaticArtCache::editorBackground, getWidth(), getHeight(), scale,
+                                [this] (juce::Graphics& ig) { paintBackground (ig); }),
+                 getLocalBounds().toFloat());
+}
+
+void CompressorPluginAudioProcessorEditor::paintBackground (juce::Graphics& g) const
 {
     g.fillAll (juce::Colour (0xFF0E0F12));
 
@@ -240,10 +284,10 @@ void CompressorPluginAudioProcessorEditor::paint (juce::Graphics& g)
     
     // Footer section background
     g.setColour (juce::Colours::white.withAlpha (0.03f));
-    g.fillRoundedRectangle (juce::Rectangle<float> (20, (float) getHeight() - 66, (float) getWidth() - 40, 46), 8.0f);
+    g.fillRoundedRectangle (juce::Rectangle<float> (20, (float) (getHeight() - analyzerHeight) - 66, (float) getWidth() - 40, 46), 8.0f);
     
     // Draw separator line between compressor sections - dynamically positioned
-    auto area = getLocalBounds().reduced (24);
+    auto area = getLocalBounds().withTrimmedBottom (analyzerHeight).reduced (24);
     area.removeFromTop (120); // Skip header section
     auto left = area.removeFromLeft (area.proportionOfWidth (0.65f));
     left.removeFromTop (10); // Skip top margin
@@ -269,7 +313,10 @@ void CompressorPluginAudioProcessorEditor::paint (juce::Graphics& g)
 
 void CompressorPluginAudioProcessorEditor::resized()
 {
-    auto area = getLocalBounds().reduced (24);
+    // Analyzer strip along the bottom; the controls keep their layout above it
+    spectrumView.setBounds (getLocalBounds().removeFromBottom (analyzerHeight).reduced (20, 0).withTrimmedBottom (20));
+
+    auto area = getLocalBounds().withTrimmedBottom (analyzerHeight).reduced (24);
 
     // Header section - Input/Output controls
     auto headerSection = area.removeFromTop (100);
@@ -468,10 +515,10 @@ void CompressorPluginAudioProcessorEditor::resized()
     // Center the mode buttons in the footer with responsive sizing
     const int minButtonW = 80;
     const int maxButtonW = 120;
-    const int buttonW = juce::jlimit(minButtonW, maxButtonW, (getWidth() - 100) / 3); // Use full plugin width like header
+    const int buttonW = juce::jlimit(minButtonW, maxButtonW, (getWidth() - 100) / 4); // Use full plugin width like header
     const int buttonH = 25;
     const int buttonSpacing = juce::jlimit(15, 25, static_cast<int>(buttonW * 0.2f)); // Proportional button spacing
-    const int totalButtonWidth = buttonW * 3 + buttonSpacing * 2;
+    const int totalButtonWidth = buttonW * 4 + buttonSpacing * 3;
     const int footerStartX = (getWidth() - totalButtonWidth) / 2; // Center relative to full plugin width like header
     
     // Position buttons in the center of the footer area, properly within the grey footer
@@ -480,6 +527,7 @@ void CompressorPluginAudioProcessorEditor::resized()
     upwardsFirstButton.setBounds (footerStartX, footerCenterY, buttonW, buttonH);
     vocalModeButton.setBounds (footerStartX + buttonW + buttonSpacing, footerCenterY, buttonW, buttonH);
     drumbusModeButton.setBounds (footerStartX + (buttonW + buttonSpacing) * 2, footerCenterY, buttonW, buttonH);
+    suggestThresholdsButton.setBounds (footerStartX + (buttonW + buttonSpacing) * 3, footerCenterY, buttonW, buttonH);
 }
 
 void CompressorPluginAudioProcessorEditor::timerCallback()
@@ -500,6 +548,17 @@ void CompressorPluginAudioProcessorEditor::timerCallback()
     smoothedInputLevel = smoothedInputLevel * smoothingCoeff + inputLevel * (1.0f - smoothingCoeff);
     smoothedOutputLevel = smoothedOutputLevel * smoothingCoeff + outputLevel * (1.0f - smoothingCoeff);
     
+    // The downwards detector's level distribution, a few times a second
+    if (--ticksUntilDistribution <= 0)
+    {
+        CompressorPluginAudioProcessor::LevelDistribution shares {};
+        processor.getLevelDistribution (0, shares);
+        inputMeter.setDistribution (shares);
+        ticksUntilDistribution = 15;
+    }
+
+    spectrumView.refresh();
+
     inputMeter.setInputValue (smoothedInputLevel);
     outputMeter.setOutputValue (smoothedOutputLevel);
     
@@ -2,6 +2,7 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "StaticArtCache.h"
 
 class GRMeter : public juce::Component
 {
@@ -19,94 +20,49 @@ public:
     void setInputValue (float inputDb) { value = juce::jlimit (-60.0f, 6.0f, inputDb); meterType = InputOutput; repaint(); }
     void setOutputValue (float outputDb) { value = juce::jlimit (-60.0f, 6.0f, outputDb); meterType = InputOutput; repaint(); }
     void setUpwardsGainValue (float gainDbPositive) { value = juce::jlimit (0.0f, 20.0f, gainDbPositive); meterType = UpwardsGain; repaint(); }
+
+    // Detector level distribution drawn behind an input/output bar, all zero to hide
+    void setDistribution (const CompressorPluginAudioProcessor::LevelDistribution& shares) { distribution = shares; }
     
     void paint (juce::Graphics& g) override
     {
-        auto bounds = getLocalBounds().reduced (4);
-        g.setColour (juce::Colours::black.withAlpha (0.7f));
-        g.fillRoundedRectangle (bounds.toFloat(), 8.0f);
-        g.setColour (juce::Colours::white.withAlpha (0.08f));
-        g.drawRoundedRectangle (bounds.toFloat(), 8.0f, 1.0f);
+        // Background and scale come from the shared cache; only the bar is drawn per frame
+        const auto art = meterType == UpwardsGain   ? StaticArtCache::upwardsGainScale
+                       : meterType == GainReduction ? StaticArtCache::gainReductionScale
+                                                    : StaticArtCache::inputOutputScale;
+        const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        g.drawImage (artCache->get (art, getWidth(), getHeight(), scale, [this] (juce::Graphics& ig) { paintScale (ig); }),
+                     getLocalBounds().toFloat());
 
-        // Meter area inside
-        auto meter = bounds.reduced (12);
+        auto meter = getLocalBounds().reduced (4).reduced (12);
 
-        // Use meter type to determine rendering behavior
-        bool isUpwardsGainMeter = (meterType == UpwardsGain);
-        bool isGainReductionMeter = (meterType == GainReduction);
-        
-        if (isUpwardsGainMeter) {
+        if (meterType == UpwardsGain) {
             // Upwards gain meter: 0 to 20dB scale, 0dB at bottom, fill upward
             const float maxShow = 20.0f;
-            const float ticks[] = { 0.0f, 5.0f, 10.0f, 15.0f, 20.0f };
-            
-            for (float t : ticks)
-            {
-                const float normalizedValue = (maxShow - t) / maxShow; // 0dB at bottom, 20dB at top
-                const float y = (float) meter.getY() + normalizedValue * (float) meter.getHeight();
-                g.setColour (juce::Colours::white.withAlpha (0.2f));
-                g.drawLine ((float) meter.getX(), y, (float) meter.getRight(), y, 1.0f);
-                juce::Rectangle<int> label ((int) meter.getRight() - 44, (int) y - 8, 44, 16);
-                g.setColour (juce::Colours::white.withAlpha (0.6f));
-                g.setFont (12.0f);
-                g.drawFittedText (juce::String ("+") + juce::String ((int) t) + " dB",
-                                  label, juce::Justification::centredLeft, 1);
-            }
-            
-            // Bar fill for upwards gain meter (fill upward)
             const float displayValue = juce::jlimit (0.0f, maxShow, value);
             const float normalizedValue = displayValue / maxShow;
             const int barHeight = (int) std::round (normalizedValue * (float) meter.getHeight());
             juce::Rectangle<int> fillRect = meter.withY (meter.getBottom() - barHeight).withHeight (barHeight);
             g.setColour (juce::Colours::lightgreen.withAlpha (0.9f));
             g.fillRoundedRectangle (fillRect.toFloat(), 6.0f);
-        } else if (!isGainReductionMeter) {
+        } else if (meterType == InputOutput) {
             // Input/Output meters: +6dB to -30dB scale, fill upward
             const float maxShow = 36.0f; // +6 to -30 = 36dB range
-            const float ticks[] = { 6.0f, 0.0f, -6.0f, -12.0f, -20.0f, -30.0f };
-            
-            for (float t : ticks)
-            {
-                const float normalizedValue = (6.0f - t) / maxShow; // +6dB at top, -30dB at bottom
-                const float y = (float) meter.getY() + normalizedValue * (float) meter.getHeight();
-                g.setColour (juce::Colours::white.withAlpha (0.2f));
-                g.drawLine ((float) meter.getX(), y, (float) meter.getRight(), y, 1.0f);
-                juce::Rectangle<int> label ((int) meter.getRight() - 44, (int) y - 8, 44, 16);
-                g.setColour (juce::Colours::white.withAlpha (0.6f));
-                g.setFont (12.0f);
-                g.drawFittedText (juce::String ((int) t) + " dB",
-                                  label, juce::Justification::centredLeft, 1);
-            }
-            
-            // Bar fill for input/output meters (fill upward)
             const float clampedValue = juce::jlimit (-30.0f, 6.0f, value);
             const float normalizedValue = (clampedValue - (-30.0f)) / maxShow; // Higher level = more fill
             const int barHeight = (int) std::round (normalizedValue * (float) meter.getHeight());
             juce::Rectangle<int> fillRect = meter.withY (meter.getBottom() - barHeight).withHeight (barHeight);
+
+            // Level distribution behind the bar, on the same scale
+            paintDistribution (g, meter);
             
             // Change color to red when exceeding 0dB
             juce::Colour meterColor = (clampedValue > 0.0f) ? juce::Colours::red : juce::Colours::skyblue;
             g.setColour (meterColor.withAlpha (0.9f));
             g.fillRoundedRectangle (fillRect.toFloat(), 6.0f);
         } else {
-            // Gain reduction meter: Always show -40dB to 0dB scale, 0dB at top, -40dB at bottom, fill from top
+            // Gain reduction meter: -40dB to 0dB scale, fill from top down
             const float maxShow = 40.0f;
-            const float ticks[] = { 0.0f, -5.0f, -10.0f, -20.0f, -30.0f, -40.0f };
-            
-            for (float t : ticks)
-            {
-                const float normalizedValue = (0.0f - t) / maxShow; // 0dB at top, -40dB at bottom
-                const float y = (float) meter.getY() + normalizedValue * (float) meter.getHeight();
-                g.setColour (juce::Colours::white.withAlpha (0.2f));
-                g.drawLine ((float) meter.getX(), y, (float) meter.getRight(), y, 1.0f);
-                juce::Rectangle<int> label ((int) meter.getRight() - 44, (int) y - 8, 44, 16);
-                g.setColour (juce::Colours::white.withAlpha (0.6f));
-                g.setFont (12.0f);
-                g.drawFittedText (juce::String ((int) t) + " dB",
-                                  label, juce::Justification::centredLeft, 1);
-            }
-            
-            // Bar fill for gain reduction (fill from top down)
             const float displayValue = juce::jlimit (0.0f, maxShow, value);
             const int barHeight = (int) std::round (displayValue / maxShow * (float) meter.getHeight());
             juce::Rectangle<int> fillRect = meter.withY (meter.getY()).withHeight (barHeight);
@@ -114,9 +70,168 @@ public:
             g.fillRoundedRectangle (fillRect.toFloat(), 6.0f);
         }
     }
+
 private:
+    // One 1 dB bin per row of the +6 to -30 dB scale, widest for the most common level
+    void paintDistribution (juce::Graphics& g, juce::Rectangle<int> meter) const
+    {
+        const float maxShare = *std::max_element (distribution.begin(), distribution.end());
+        if (maxShare <= 0.0f)
+            return;
+
+        const float rowHeight = (float) meter.getHeight() / 36.0f;
+        g.setColour (juce::Colours::white.withAlpha (0.15f));
+
+        for (int b = 0; b < ULTRADYN_HISTOGRAM_BINS; ++b)
+        {
+            const float topDb = (float) (ULTRADYN_HISTOGRAM_MIN_DB + b + 1);
+            if (topDb <= -30.0f || topDb > 6.0f || distribution[(size_t) b] <= 0.0f)
+                continue;
+
+            g.fillRect (juce::Rectangle<float> ((float) meter.getX(), (float) meter.getY() + (6.0f - topDb) * rowHeight,
+                                                (float) meter.getWidth() * distribution[(size_t) b] / maxShare, rowHeight));
+        }
+    }
+
+    // Panel, tick lines and dB labels for the current meter type
+    void paintScale (juce::Graphics& g) const
+    {
+        auto bounds = getLocalBounds().reduced (4);
+        g.setColour (juce::Colours::black.withAlpha (0.7f));
+        g.fillRoundedRectangle (bounds.toFloat(), 8.0f);
+        g.setColour (juce::Colours::white.withAlpha (0.08f));
+        g.drawRoundedRectangle (bounds.toFloat(), 8.0f, 1.0f);
+
+        // Meter area inside
+        auto meter = bounds.reduced (12);
+
+        const auto drawTick = [&g, meter] (float normalizedValue, const juce::String& text)
+        {
+            const float y = (float) meter.getY() + normalizedValue * (float) meter.getHeight();
+            g.setColour (juce::Colours::white.withAlpha (0.2f));
+            g.drawLine ((float) meter.getX(), y, (float) meter.getRight(), y, 1.0f);
+            juce::Rectangle<int> label ((int) meter.getRight() - 44, (int) y - 8, 44, 16);
+            g.setColour (juce::Colours::white.withAlpha (0.6f));
+            g.setFont (12.0f);
+            g.drawFittedText (text, label, juce::Justification::centredLeft, 1);
+        };
+
+        if (meterType == UpwardsGain) {
+            // 0dB at bottom, 20dB at top
+            for (float t : { 0.0f, 5.0f, 10.0f, 15.0f, 20.0f })
+                drawTick ((20.0f - t) / 20.0f, juce::String ("+") + juce::String ((int) t) + " dB");
+        } else if (meterType == InputOutput) {
+            // +6dB at top, -30dB at bottom
+            for (float t : { 6.0f, 0.0f, -6.0f, -12.0f, -20.0f, -30.0f })
+                drawTick ((6.0f - t) / 36.0f, juce::String ((int) t) + " dB");
+        } else {
+            // 0dB at top, -40dB at bottom
+            for (float t : { 0.0f, -5.0f, -10.0f, -20.0f, -30.0f, -40.0f })
+                drawTick ((0.0f - t) / 40.0f, juce::String ((int) t) + " dB");
+        }
+    }
+
     float value = 0.0f;
     MeterType meterType;
+    CompressorPluginAudioProcessor::LevelDistribution distribution {};
+    juce::SharedResourcePointer<StaticArtCache> artCache;
+};
+
+// Detector and output spectra from the processor's analyzer, which builds the
+// paths on its own thread; this only strokes them over a cached grid
+class SpectrumView : public juce::Component
+{
+public:
+    explicit SpectrumView (SpectrumAnalyzer& a) : analyzer (a) {}
+    ~SpectrumView() override { setActive (false); }
+
+    // The analyzer runs while any view of it is active
+    void setActive (bool shouldBeActive)
+    {
+        if (shouldBeActive == active)
+            return;
+
+        active = shouldBeActive;
+        if (active)
+            analyzer.addViewer();
+        else
+            analyzer.removeViewer();
+    }
+
+    // From the editor's timer: picks up new paths, if there are any
+    void refresh()
+    {
+        if (analyzer.getPaths (detectorPath, outputPath))
+            repaint();
+    }
+
+    void resized() override
+    {
+        const auto plot = getPlotArea();
+        analyzer.setDisplaySize (plot.getWidth(), plot.getHeight());
+    }
+
+    void paint (juce::Graphics& g) override
+    {
+        const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        g.drawImage (artCache->get (StaticArtCache::spectrumGrid, getWidth(), getHeight(), scale, [this] (juce::Graphics& ig) { paintGrid (ig); }),
+                     getLocalBounds().toFloat());
+
+        const auto plot = getPlotArea();
+        const auto toPlot = juce::AffineTransform::translation ((float) plot.getX(), (float) plot.getY());
+        g.setColour (juce::Colours::orange.withAlpha (0.8f));
+        g.strokePath (detectorPath, juce::PathStrokeType (1.5f), toPlot);
+        g.setColour (juce::Colours::skyblue.withAlpha (0.9f));
+        g.strokePath (outputPath, juce::PathStrokeType (1.5f), toPlot);
+    }
+
+private:
+    juce::Rectangle<int> getPlotArea() const { return getLocalBounds().reduced (16, 12); }
+
+    // Panel, frequency and level lines, and the legend
+    void paintGrid (juce::Graphics& g) const
+    {
+        auto bounds = getLocalBounds().reduced (4);
+        g.setColour (juce::Colours::black.withAlpha (0.7f));
+        g.fillRoundedRectangle (bounds.toFloat(), 8.0f);
+        g.setColour (juce::Colours::white.withAlpha (0.08f));
+        g.drawRoundedRectangle (bounds.toFloat(), 8.0f, 1.0f);
+
+        const auto plot = getPlotArea().toFloat();
+        const float octaves = std::log2 (SpectrumAnalyzer::maxFrequency / SpectrumAnalyzer::minFrequency);
+        g.setFont (11.0f);
+
+        for (const float hz : { 50.0f, 100.0f, 200.0f, 500.0f, 1000.0f, 2000.0f, 5000.0f, 10000.0f })
+        {
+            const float x = plot.getX() + plot.getWidth() * std::log2 (hz / SpectrumAnalyzer::minFrequency) / octaves;
+            g.setColour (juce::Colours::white.withAlpha (0.1f));
+            g.drawLine (x, plot.getY(), x, plot.getBottom(), 1.0f);
+            g.setColour (juce::Colours::white.withAlpha (0.5f));
+            g.drawText (hz >= 1000.0f ? juce::String ((int) (hz / 1000.0f)) + "k" : juce::String ((int) hz),
+                        juce::Rectangle<float> (x + 3.0f, plot.getBottom() - 14.0f, 30.0f, 14.0f), juce::Justification::centredLeft);
+        }
+
+        const float dbRange = SpectrumAnalyzer::maxDb - SpectrumAnalyzer::minDb;
+        for (float dB = SpectrumAnalyzer::maxDb - 20.0f; dB > SpectrumAnalyzer::minDb; dB -= 20.0f)
+        {
+            const float y = plot.getY() + plot.getHeight() * (SpectrumAnalyzer::maxDb - dB) / dbRange;
+            g.setColour (juce::Colours::white.withAlpha (0.1f));
+            g.drawLine (plot.getX(), y, plot.getRight(), y, 1.0f);
+            g.setColour (juce::Colours::white.withAlpha (0.5f));
+            g.drawText (juce::String ((int) dB) + " dB", juce::Rectangle<float> (plot.getX() + 3.0f, y - 14.0f, 50.0f, 14.0f),
+                        juce::Justification::centredLeft);
+        }
+
+        g.setColour (juce::Colours::orange);
+        g.drawText ("Detector", juce::Rectangle<float> (plot.getRight() - 130.0f, plot.getY(), 60.0f, 14.0f), juce::Justification::centredRight);
+        g.setColour (juce::Colours::skyblue);
+        g.drawText ("Output", juce::Rectangle<float> (plot.getRight() - 60.0f, plot.getY(), 60.0f, 14.0f), juce::Justification::centredRight);
+    }
+
+    SpectrumAnalyzer& analyzer;
+    juce::Path detectorPath, outputPath;
+    bool active = false;
+    juce::SharedResourcePointer<StaticArtCache> artCache;
 };
 
 class CompressorPluginAudioProcessorEditor  : public juce::AudioProcessorEditor,
@@ -129,9 +244,13 @@ public:
 
     void paint (juce::Graphics&) override;
     void resized() override;
+    void visibilityChanged() override;
+    void parentHierarchyChanged() override;
 
 private:
     void timerCallback() override;
+    void paintBackground (juce::Graphics&) const;
+    void attachToParameters();
     void valueChanged(juce::Value& value) override;
     void setupSlider(juce::Slider&, const juce::String&, bool isDial = true);
     void setupLabel(juce::Label&, const juce::String&);
@@ -169,6 +288,9 @@ private:
     juce::Label upwardsOutputLabel;
     juce::ToggleButton upwardsFirstButton;
 
+    // Sets both thresholds from the level histograms
+    juce::TextButton suggestThresholdsButton;
+
     // Labels for header knobs
     juce::Label inputGainLabel;
     juce::Label outputGainLabel;
@@ -192,6 +314,10 @@ private:
     GRMeter inputMeter;
     GRMeter outputMeter;
     GRMeter upwardsMeter;
+
+    // Detector and output spectra, in a strip below the controls
+    SpectrumView spectrumView;
+    static constexpr int analyzerHeight = 170;
     
     // Meter labels
     juce::Label inputMeterLabel;
@@ -207,7 +333,8 @@ private:
     juce::ToggleButton downwardsBypassButton;
     juce::ToggleButton upwardsBypassButton;
 
-    // Attachments for downwards compressor
+    // Attachments for downwards compressor; all attachments are made when the
+    // editor is first shown (attachToParameters), not in the constructor
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> inputGainAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> outputGainAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> globalMixAttachment;
@@ -234,9 +361,15 @@ private:
     juce::Value downwardsBypassValue;
     juce::Value upwardsBypassValue;
     
+    // Shared with every other open editor
+    juce::SharedResourcePointer<StaticArtCache> artCache;
+
     // Meter smoothing variables
     float smoothedInputLevel = -60.0f;
     float smoothedOutputLevel = -60.0f;
 
+    // Timer ticks until the input meter's level distribution is refreshed
+    int ticksUntilDistribution = 0;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompressorPluginAudioProcessorEditor)
 };
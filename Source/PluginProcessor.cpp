@@ -1,5 +1,18 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "RealtimeSafety.h"
+
+namespace
+{
+    // Output-only: hosts show meter parameters as read-only
+    struct QualityTierParameter : public juce::AudioParameterInt
+    {
+        QualityTierParameter() : juce::AudioParameterInt ("QUALITY_TIER", "Quality Tier", 0, ULTRADYN_NUM_QUALITY_TIERS - 1, 0) {}
+
+        Category getCategory() const override { return otherMeter; }
+        bool isAutomatable() const override   { return false; }
+    };
+}
 
 //==============================================================================
 CompressorPluginAudioProcessor::CompressorPluginAudioProcessor()
@@ -15,20 +28,36 @@ CompressorPluginAudioProcessor::CompressorPluginAudioProcessor()
     // Oversampling disabled to prevent crashes
     // oversampling = nullptr;
     // oversamplingEnabled = false;
-    
-    // Initialize upwards compressor state variables to prevent audio pops
-    upwardsEnv = 1.0e-12f; // Small non-zero value to prevent division by zero
-    upwardsSmoothGain = 1.0f;
-    upwardsAttackCoeff = 0.0f;
-    upwardsReleaseCoeff = 0.0f;
-    currentUpwardsGaindB.store(0.0f);
-    upwardsInitialRamp = true; // Start in initial ramp mode
-    upwardsStartupDelay = 0; // Reset startup delay
-    audioIsActive = false; // Start with audio inactive
-    audioInactiveCounter = 0; // Reset inactive counter
+
+    jassert (core != nullptr);
+
+    downwardsBypassParam = apvts.getRawParameterValue ("DOWNWARDS_BYPASS");
+    upwardsBypassParam   = apvts.getRawParameterValue ("UPWARDS_BYPASS");
+    qualityTierParam     = dynamic_cast<juce::AudioParameterInt*> (apvts.getParameter ("QUALITY_TIER"));
+
+    // The core keeps its own copy of every parameter; push the current values
+    // and forward each change from then on
+    for (int i = 0; i < ULTRADYN_NUM_PARAMS; ++i)
+    {
+        const char* id = ultradyn_param_id (i);
+        jassert (apvts.getParameter (id) != nullptr);
+
+        ultradyn_set_param (core.get(), i, apvts.getRawParameterValue (id)->load());
+        apvts.addParameterListener (id, this);
+    }
+
+    // Engine switches and the quality tier are picked up here, on the message
+    // thread, rather than posted from the audio thread
+    startTimerHz (20);
 }
 
-CompressorPluginAudioProcessor::~CompressorPluginAudioProcessor() = default;
+CompressorPluginAudioProcessor::~CompressorPluginAudioProcessor()
+{
+    stopTimer();
+
+    for (int i = 0; i < ULTRADYN_NUM_PARAMS; ++i)
+        apvts.removeParameterListener (ultradyn_param_id (i), this);
+}
 
 //==============================================================================
 bool CompressorPluginAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
@@ -41,456 +70,93 @@ bool CompressorPluginAudioProcessor::isBusesLayoutSupported (const BusesLayout&
 
 void CompressorPluginAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    const int numIn = juce::jmax (1, getTotalNumInputChannels());
-    wetBuffer.setSize (numIn, samplesPerBlock);
-    scBuffer.setSize (1, samplesPerBlock);
-
-    scEQ.reset();
-
-    // Initialize envelope followers to prevent pops when audio starts
-    env = 1.0e-12f;
-    upwardsEnv = 1.0e-12f;
-    smoothGain = 1.0f;
-    upwardsSmoothGain = 1.0f;
-    upwardsInitialRamp = true; // Reset initial ramp mode
-    upwardsStartupDelay = 0; // Reset startup delay
-    audioIsActive = false; // Reset audio active state
-    audioInactiveCounter = 0; // Reset inactive counter
-
-    updateTimeConstants();
-    updateSidechainEQ();
+    juce::ignoreUnused (samplesPerBlock);
+
+    // The core works in fixed internal sub-blocks, whatever block size the host uses
+    const int numChannels = juce::jmax (1, getTotalNumInputChannels(), getTotalNumOutputChannels());
+    ultradyn_prepare (core.get(), sampleRate, numChannels);
+    analyzer.setSampleRate (sampleRate);
+    setLatencySamples (ultradyn_latency_samples (core.get()));
 }
 
-void CompressorPluginAudioProcessor::releaseResources() 
+size_t CompressorPluginAudioProcessor::getMemoryFootprintBytes() const noexcept
 {
-    // Oversampling disabled to prevent crashes
-    // oversampling = nullptr;
+    // Excludes the parameter tree's own heap; the benchmark measures that by counting allocations
+    return sizeof (*this) + (size_t) ultradyn_memory_footprint (core.get());
 }
 
-void CompressorPluginAudioProcessor::updateTimeConstants()
+size_t CompressorPluginAudioProcessor::getScratchBytes() const noexcept
 {
-    const float attackMs  = apvts.getRawParameterValue ("ATTACK")->load();
-    const float releaseMs = apvts.getRawParameterValue ("RELEASE")->load();
-    const double sr = juce::jmax (1.0, getSampleRate());
-    // tiny +1 inside to avoid zero divisions in pathological cases
-    attackCoeff  = std::exp (-1.0f / ((float) (attackMs  * 0.001 * sr) + 1.0f));
-    releaseCoeff = std::exp (-1.0f / ((float) (releaseMs * 0.001 * sr) + 1.0f));
-
-    // Upwards compressor time constants
-    const float upwardsAttackMs  = apvts.getRawParameterValue ("UPWARDS_ATTACK")->load();
-    const float upwardsReleaseMs = apvts.getRawParameterValue ("UPWARDS_RELEASE")->load();
-    upwardsAttackCoeff  = std::exp (-1.0f / ((float) (upwardsAttackMs  * 0.001 * sr) + 1.0f));
-    upwardsReleaseCoeff = std::exp (-1.0f / ((float) (upwardsReleaseMs * 0.001 * sr) + 1.0f));
+    return (size_t) ultradyn_scratch_bytes (core.get());
 }
 
-
-
-void CompressorPluginAudioProcessor::updateSidechainEQ()
+bool CompressorPluginAudioProcessor::getLevelDistribution (int stage, LevelDistribution& shares) const noexcept
 {
-    // Sidechain EQ modes: boost or cut at 1.5 kHz for different compression focuses
-    const double sr = juce::jmax (1.0, getSampleRate());
-    const double freq = 1500.0;
-    const float  q    = 0.7071f; // wide, musical Q
-    
-    if (vocalModeEnabled)
-    {
-        // Vocal mode: threshold-coupled peak gain, up to +5 dB as threshold lowers
-        const float thresholdMin = -60.0f;
-        const float thresholdMax = 0.0f;
-        const float thr = apvts.getRawParameterValue ("THRESHOLD")->load();
-        const float tNorm = juce::jlimit (0.0f, 1.0f, (thresholdMax - thr) / (thresholdMax - thresholdMin));
-        const float peakDb = tNorm * 5.0f; // 0 .. +5 dB
-        scEQ.setPeak (sr, freq, q, peakDb);
-    }
-    else if (drumbusModeEnabled)
-    {
-        // Drumbus mode: threshold-coupled peak cut, up to -5 dB as threshold lowers
-        const float thresholdMin = -60.0f;
-        const float thresholdMax = 0.0f;
-        const float thr = apvts.getRawParameterValue ("THRESHOLD")->load();
-        const float tNorm = juce::jlimit (0.0f, 1.0f, (thresholdMax - thr) / (thresholdMax - thresholdMin));
-        const float peakDb = tNorm * -5.0f; // 0 .. -5 dB
-        scEQ.setPeak (sr, freq, q, peakDb);
-    }
-    else
-    {
-        // Normal mode: no sidechain EQ boost
-        scEQ.setPeak (sr, freq, q, 0.0f);
-    }
+    unsigned int counts[ULTRADYN_HISTOGRAM_BINS];
+    const auto total = ultradyn_get_histogram (core.get(), stage, counts);
+    for (int b = 0; b < ULTRADYN_HISTOGRAM_BINS; ++b)
+        shares[(size_t) b] = total > 0 ? (float) ((double) counts[b] / (double) total) : 0.0f;
+    return total > 0;
 }
 
-float CompressorPluginAudioProcessor::computeGain (float scSample) noexcept
+void CompressorPluginAudioProcessor::applySuggestedThresholds()
 {
-    // RMS detector with optimized smoothing to reduce aliasing
-    const float x2 = scSample * scSample;
-    env = x2 + (env - x2) * 0.99f; // Faster response, less smoothing
-    
-    // Ensure envelope doesn't get stuck at zero
-    if (env < 1.0e-12f) env = 1.0e-12f;
-    
-    const float rms = std::sqrt (env);
-    const float levelDb = juce::Decibels::gainToDecibels (rms);
-
-    const float thr   = apvts.getRawParameterValue ("THRESHOLD")->load();
-    const float ratio = apvts.getRawParameterValue ("RATIO")->load();
-    const float knee  = apvts.getRawParameterValue ("KNEE")->load();
-
-    const float over = levelDb - thr;
-    float grDb = 0.0f;
-
-    if (knee > 0.0f)
-    {
-        const float halfKnee = 0.5f * knee;
-        if (over > -halfKnee && over < halfKnee)
-        {
-            const float x = (over + halfKnee) / juce::jmax (1.0e-6f, knee); // 0..1
-            const float soft = x * x * (3.0f - 2.0f * x);                    // smoothstep
-            grDb = soft * (over - over / juce::jmax (1.0f, ratio));
-        }
-        else if (over >= halfKnee)
-        {
-            grDb = (over - over / juce::jmax (1.0f, ratio));
-        }
-    }
-    else if (over > 0.0f)
+    const auto apply = [this] (const char* id, float dB)
     {
-        grDb = (over - over / juce::jmax (1.0f, ratio));
-    }
-
-    const float target = juce::Decibels::decibelsToGain (-grDb);
-    if (target < smoothGain) smoothGain = smoothGain * attackCoeff  + target * (1.0f - attackCoeff);
-    else                     smoothGain = smoothGain * releaseCoeff + target * (1.0f - releaseCoeff);
-
-    currentGRdB.store (juce::jlimit (0.0f, 60.0f, -juce::Decibels::gainToDecibels (smoothGain + 1.0e-9f)));
-    return smoothGain;
+        auto* p = apvts.getParameter (id);
+        p->beginChangeGesture();
+        p->setValueNotifyingHost (p->convertTo0to1 (dB));
+        p->endChangeGesture();
+    };
+
+    apply ("THRESHOLD",         ultradyn_suggest_threshold (core.get(), 0, 30.0f));
+    apply ("UPWARDS_THRESHOLD", ultradyn_suggest_threshold_for_gain (core.get(), 1, 3.0f));
 }
 
-float CompressorPluginAudioProcessor::computeUpwardsGain (float scSample) noexcept
+void CompressorPluginAudioProcessor::releaseResources() 
 {
-    // RMS detector with much slower initial response to prevent pops
-    const float x2 = scSample * scSample;
-    
-    // Use a very slow initial ramp to prevent sudden jumps when audio starts
-    if (upwardsInitialRamp)
-    {
-        upwardsEnv = x2 * 0.001f + upwardsEnv * 0.999f; // Very slow initial ramp
-        if (upwardsEnv > 1.0e-6f) upwardsInitialRamp = false; // Switch to normal mode once we have some signal
-    }
-    else
-    {
-        upwardsEnv = x2 + (upwardsEnv - x2) * 0.99f; // Normal response
-    }
-    
-    // Ensure envelope doesn't get stuck at zero
-    if (upwardsEnv < 1.0e-12f) upwardsEnv = 1.0e-12f;
-    
-    const float rms = std::sqrt (upwardsEnv);
-    const float levelDb = juce::Decibels::gainToDecibels (rms);
-
-    const float thr   = apvts.getRawParameterValue ("UPWARDS_THRESHOLD")->load();
-    const float ratio = apvts.getRawParameterValue ("UPWARDS_RATIO")->load();
-    const float knee  = apvts.getRawParameterValue ("UPWARDS_KNEE")->load();
-
-    const float under = thr - levelDb; // For upwards compression, we look at how much we're UNDER the threshold
-    float gainDb = 0.0f;
+    // Oversampling disabled to prevent crashes
+    // oversampling = nullptr;
+}
 
-    if (knee > 0.0f)
-    {
-        const float halfKnee = 0.5f * knee;
-        if (under > -halfKnee && under < halfKnee)
-        {
-            const float x = (under + halfKnee) / juce::jmax (1.0e-6f, knee); // 0..1
-            const float soft = x * x * (3.0f - 2.0f * x);                    // smoothstep
-            gainDb = soft * (under - under / juce::jmax (1.0f, ratio));
-        }
-        else if (under >= halfKnee)
-        {
-            gainDb = (under - under / juce::jmax (1.0f, ratio));
-        }
-    }
-    else if (under > 0.0f)
-    {
-        gainDb = (under - under / juce::jmax (1.0f, ratio));
-    }
+void CompressorPluginAudioProcessor::parameterChanged (const juce::String& parameterID, float newValue)
+{
+    // May be called from any thread, including the audio thread during automation;
+    // the core only stores the value and marks its coefficient caches dirty
+    const int index = ultradyn_param_index (parameterID.toRawUTF8());
+    ultradyn_set_param (core.get(), index, newValue);
+
+    // The limiter's lookahead and the spectral mode change the latency, and
+    // joining a link group or starting the channel threads allocates; all are
+    // handled on the message thread by the next timer tick
+    if (index == ULTRADYN_PARAM_TRUE_PEAK_LIMITER || index == ULTRADYN_PARAM_LINK_GROUP
+        || index == ULTRADYN_PARAM_SPECTRAL_MODE || index == ULTRADYN_PARAM_CHANNEL_THREADS)
+        engineChangePending.store (true, std::memory_order_release);
+}
 
-    const float target = juce::Decibels::decibelsToGain (gainDb);
-    
-    // Much more gradual gain smoothing to prevent sudden jumps
-    if (upwardsSmoothGain < 0.5f) // If gain is low, ramp up very slowly
-    {
-        upwardsSmoothGain = upwardsSmoothGain * 0.98f + target * 0.02f;
-    }
-    else
+void CompressorPluginAudioProcessor::timerCallback()
+{
+    if (engineChangePending.exchange (false, std::memory_order_acquire))
     {
-        if (target > upwardsSmoothGain) upwardsSmoothGain = upwardsSmoothGain * upwardsAttackCoeff  + target * (1.0f - upwardsAttackCoeff);
-        else                            upwardsSmoothGain = upwardsSmoothGain * upwardsReleaseCoeff + target * (1.0f - upwardsReleaseCoeff);
+        setLatencySamples (ultradyn_latency_samples (core.get()));
+        ultradyn_update_link (core.get());
+        ultradyn_update_channel_threads (core.get());
     }
 
-    currentUpwardsGaindB.store (juce::jlimit (0.0f, 20.0f, juce::Decibels::gainToDecibels (upwardsSmoothGain + 1.0e-9f)));
-    return upwardsSmoothGain;
+    // Tier changes are rare; the host hears about them from here
+    const int tier = ultradyn_quality_tier (core.get());
+    if (qualityTierParam != nullptr && qualityTierParam->get() != tier)
+        *qualityTierParam = tier;
 }
 
 void CompressorPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
 {
     juce::ScopedNoDenormals noDenormals;
-    const int numSamples = buffer.getNumSamples();
-    const int numCh = buffer.getNumChannels();
-
-    updateTimeConstants();
-    updateSidechainEQ();
+    rtsafety::ScopedAudioThread audioThreadScope; // no-op unless built with ULTRADYN_RT_CHECKS
 
-    // Check if vocal mode and drumbus mode are enabled (mutually exclusive)
-    vocalModeEnabled = apvts.getRawParameterValue ("VOCAL_MODE")->load() > 0.5f;
-    drumbusModeEnabled = apvts.getRawParameterValue ("DRUMBUS_MODE")->load() > 0.5f && !vocalModeEnabled;
-    
-    // Reset envelope followers if they're in an invalid state to prevent pops
-    if (env < 1.0e-12f) env = 1.0e-12f;
-    if (upwardsEnv < 1.0e-12f) upwardsEnv = 1.0e-12f;
-    
-    // Check processing order
-    bool upwardsFirst = apvts.getRawParameterValue ("UPWARDS_FIRST")->load() > 0.5f;
-    
-    {
-        // Standard processing without oversampling
-        // Input gain
-        const float inGain = juce::Decibels::decibelsToGain (apvts.getRawParameterValue ("INPUT_GAIN")->load());
-        buffer.applyGain (inGain);
-        
-        // Calculate input level (after input gain) and detect audio activity
-        float inputPeak = 0.0f;
-        for (int ch = 0; ch < numCh; ++ch)
-        {
-            const float* inputData = buffer.getReadPointer(ch);
-            for (int n = 0; n < numSamples; ++n)
-            {
-                inputPeak = juce::jmax(inputPeak, std::abs(inputData[n]));
-            }
-        }
-        inputLevel = inputPeak > 0.0f ? juce::Decibels::gainToDecibels(inputPeak) : -60.0f;
-        
-        // Detect audio activity (threshold at -60dB)
-        const bool hasAudio = inputPeak > 1.0e-3f; // -60dB threshold
-        if (hasAudio)
-        {
-            audioInactiveCounter = 0; // Reset inactive counter
-            if (!audioIsActive)
-            {
-                audioIsActive = true;
-                upwardsStartupDelay = 0; // Reset startup delay when audio starts
-            }
-        }
-        else
-        {
-            audioInactiveCounter += numSamples;
-            if (audioInactiveCounter > DEACTIVATION_THRESHOLD)
-            {
-                audioIsActive = false; // Deactivate after 50ms of silence
-                upwardsStartupDelay = 0; // Reset startup delay
-                // Reset upwards compressor state when audio becomes inactive
-                upwardsEnv = 1.0e-12f;
-                upwardsSmoothGain = 1.0f;
-                upwardsInitialRamp = true;
-                currentUpwardsGaindB.store(0.0f);
-            }
-        }
-
-        // Wet copy
-        wetBuffer.makeCopyOf (buffer, true);
-
-        // Build internal sidechain: sum main input to mono
-        scBuffer.clear();
-        float* scWrite = scBuffer.getWritePointer (0);
-        for (int n = 0; n < numSamples; ++n)
-        {
-            float s = 0.0f;
-            for (int ch = 0; ch < numCh; ++ch)
-                s += buffer.getReadPointer (ch)[n];
-            scWrite[n] = s * (1.0f / juce::jmax (1, numCh));
-        }
-
-        // Apply detector EQ
-        float* scData = scBuffer.getWritePointer (0);
-        for (int n = 0; n < numSamples; ++n)
-            scData[n] = scEQ.process (scData[n]);
-
-        // Process based on order with proper cascading
-        if (upwardsFirst)
-        {
-            // Upwards compressor first
-            const bool upwardsBypass = apvts.getRawParameterValue ("UPWARDS_BYPASS")->load();
-            if (!upwardsBypass && audioIsActive) // Process if NOT bypassed AND audio is active
-            {
-                // Add startup delay to prevent initial surge
-                if (upwardsStartupDelay < ACTIVATION_DELAY_SAMPLES) // Wait for 100ms at 44.1kHz
-                {
-                    upwardsStartupDelay += numSamples;
-                    // During startup delay, just pass through without processing
-                }
-                else
-                {
-                    const float* scRead = scBuffer.getReadPointer (0);
-                    const float upwardsMix = apvts.getRawParameterValue ("UPWARDS_MIX")->load() * 0.01f; // 0..1
-                    
-                    for (int n = 0; n < numSamples; ++n)
-                    {
-                        const float g = computeUpwardsGain (scRead[n]);
-                        for (int ch = 0; ch < numCh; ++ch)
-                        {
-                            const float originalSample = wetBuffer.getReadPointer (ch)[n];
-                            const float processedSample = originalSample * g;
-                            wetBuffer.getWritePointer (ch)[n] = originalSample * (1.0f - upwardsMix) + processedSample * upwardsMix;
-                        }
-                    }
-                }
-                
-                // Apply upwards output gain (feeds into downwards compressor)
-                const float upwardsOutputGain = juce::Decibels::decibelsToGain (apvts.getRawParameterValue ("UPWARDS_OUTPUT")->load());
-                for (int ch = 0; ch < numCh; ++ch)
-                    wetBuffer.applyGain (ch, 0, numSamples, upwardsOutputGain);
-            }
-            
-            // Update sidechain for downwards compressor to use processed signal
-            scBuffer.clear();
-            float* scWrite = scBuffer.getWritePointer (0);
-            for (int n = 0; n < numSamples; ++n)
-            {
-                float s = 0.0f;
-                for (int ch = 0; ch < numCh; ++ch)
-                    s += wetBuffer.getReadPointer (ch)[n];
-                scWrite[n] = s * (1.0f / juce::jmax (1, numCh));
-            }
-            
-            // Apply detector EQ to updated sidechain
-            float* scData = scBuffer.getWritePointer (0);
-            for (int n = 0; n < numSamples; ++n)
-                scData[n] = scEQ.process (scData[n]);
-            
-            // Then downwards compressor (processes the output of upwards compressor)
-            const bool downwardsBypass = apvts.getRawParameterValue ("DOWNWARDS_BYPASS")->load();
-            if (!downwardsBypass) // Process if NOT bypassed
-            {
-                const float downwardsMix = apvts.getRawParameterValue ("MIX")->load() * 0.01f; // 0..1
-                for (int n = 0; n < numSamples; ++n)
-                {
-                    const float g = computeGain (scData[n]);
-                    for (int ch = 0; ch < numCh; ++ch)
-                    {
-                        const float originalSample = wetBuffer.getReadPointer (ch)[n];
-                        const float processedSample = originalSample * g;
-                        wetBuffer.getWritePointer (ch)[n] = originalSample * (1.0f - downwardsMix) + processedSample * downwardsMix;
-                    }
-                }
-                
-                // Apply downwards output gain (feeds into global mix)
-                const float downwardsOutputGain = juce::Decibels::decibelsToGain (apvts.getRawParameterValue ("DOWNWARDS_OUTPUT")->load());
-                for (int ch = 0; ch < numCh; ++ch)
-                    wetBuffer.applyGain (ch, 0, numSamples, downwardsOutputGain);
-            }
-        }
-        else
-        {
-            // Downwards compressor first
-            const bool downwardsBypass = apvts.getRawParameterValue ("DOWNWARDS_BYPASS")->load();
-            if (!downwardsBypass) // Process if NOT bypassed
-            {
-                const float* scRead = scBuffer.getReadPointer (0);
-                const float downwardsMix = apvts.getRawParameterValue ("MIX")->load() * 0.01f; // 0..1
-                
-                for (int n = 0; n < numSamples; ++n)
-                {
-                    const float g = computeGain (scRead[n]);
-                    for (int ch = 0; ch < numCh; ++ch)
-                    {
-                        const float originalSample = wetBuffer.getReadPointer (ch)[n];
-                        const float processedSample = originalSample * g;
-                        wetBuffer.getWritePointer (ch)[n] = originalSample * (1.0f - downwardsMix) + processedSample * downwardsMix;
-                    }
-                }
-                
-                // Apply downwards output gain (feeds into upwards compressor)
-                const float downwardsOutputGain = juce::Decibels::decibelsToGain (apvts.getRawParameterValue ("DOWNWARDS_OUTPUT")->load());
-                for (int ch = 0; ch < numCh; ++ch)
-                    wetBuffer.applyGain (ch, 0, numSamples, downwardsOutputGain);
-            }
-            
-            // Update sidechain for upwards compressor to use processed signal
-            scBuffer.clear();
-            float* scWrite = scBuffer.getWritePointer (0);
-            for (int n = 0; n < numSamples; ++n)
-            {
-                float s = 0.0f;
-                for (int ch = 0; ch < numCh; ++ch)
-                    s += wetBuffer.getReadPointer (ch)[n];
-                scWrite[n] = s * (1.0f / juce::jmax (1, numCh));
-            }
-            
-            // Apply detector EQ to updated sidechain
-            float* scData = scBuffer.getWritePointer (0);
-            for (int n = 0; n < numSamples; ++n)
-                scData[n] = scEQ.process (scData[n]);
-            
-            // Then upwards compressor (processes the output of downwards compressor)
-            const bool upwardsBypass = apvts.getRawParameterValue ("UPWARDS_BYPASS")->load();
-            if (!upwardsBypass && audioIsActive) // Process if NOT bypassed AND audio is active
-            {
-                // Add startup delay to prevent initial surge
-                if (upwardsStartupDelay < ACTIVATION_DELAY_SAMPLES) // Wait for 100ms at 44.1kHz
-                {
-                    upwardsStartupDelay += numSamples;
-                    // During startup delay, just pass through without processing
-                }
-                else
-                {
-                    const float upwardsMix = apvts.getRawParameterValue ("UPWARDS_MIX")->load() * 0.01f; // 0..1
-                    for (int n = 0; n < numSamples; ++n)
-                    {
-                        const float g = computeUpwardsGain (scData[n]);
-                        for (int ch = 0; ch < numCh; ++ch)
-                        {
-                            const float originalSample = wetBuffer.getReadPointer (ch)[n];
-                            const float processedSample = originalSample * g;
-                            wetBuffer.getWritePointer (ch)[n] = originalSample * (1.0f - upwardsMix) + processedSample * upwardsMix;
-                        }
-                    }
-                }
-                
-                // Apply upwards output gain (feeds into global mix)
-                const float upwardsOutputGain = juce::Decibels::decibelsToGain (apvts.getRawParameterValue ("UPWARDS_OUTPUT")->load());
-                for (int ch = 0; ch < numCh; ++ch)
-                    wetBuffer.applyGain (ch, 0, numSamples, upwardsOutputGain);
-            }
-        }
-
-        // Apply global mix (wet/dry blend)
-        const float globalMix = apvts.getRawParameterValue ("GLOBAL_MIX")->load() * 0.01f; // 0..1
-        for (int ch = 0; ch < numCh; ++ch)
-        {
-            const float* dryData = buffer.getReadPointer(ch);
-            const float* wetData = wetBuffer.getReadPointer(ch);
-            float* outputData = buffer.getWritePointer(ch);
-            
-            for (int n = 0; n < numSamples; ++n)
-            {
-                outputData[n] = dryData[n] * (1.0f - globalMix) + wetData[n] * globalMix;
-            }
-        }
-
-        // Apply global output gain (after global mix)
-        const float outGain = juce::Decibels::decibelsToGain (apvts.getRawParameterValue ("OUTPUT_GAIN")->load());
-        buffer.applyGain (outGain);
-        
-        // Calculate output level (after all processing)
-        float outputPeak = 0.0f;
-        for (int ch = 0; ch < numCh; ++ch)
-        {
-            const float* outputData = buffer.getReadPointer(ch);
-            for (int n = 0; n < numSamples; ++n)
-            {
-                outputPeak = juce::jmax(outputPeak, std::abs(outputData[n]));
-            }
-        }
-        outputLevel = outputPeak > 0.0f ? juce::Decibels::gainToDecibels(outputPeak) : -60.0f;
-    }
+    // Hosts may switch to and from offline bouncing between any two blocks
+    ultradyn_set_non_realtime (core.get(), isNonRealtime() ? 1 : 0);
+    ultradyn_process (core.get(), buffer.getArrayOfWritePointers(), buffer.getNumChannels(), buffer.getNumSamples());
 }
 
 //==============================================================================
@@ -509,6 +175,10 @@ void CompressorPluginAudioProcessor::setStateInformation (const void* data, int
 {
     auto tree = juce::ValueTree::readFromData (data, (size_t) sizeInBytes);
     if (tree.isValid()) apvts.replaceState (tree);
+
+    // The restored switches may change the latency, link or channel threads
+    // (the saved tier is stale too; the next tick reports the live one)
+    engineChangePending.store (true, std::memory_order_release);
 }
 
 //==============================================================================
@@ -530,6 +200,16 @@ juce::AudioProcessorValueTreeState::ParameterLayout CompressorPluginAudioProcess
     params.push_back (std::make_unique<juce::AudioParameterBool> ("DOWNWARDS_BYPASS", "Downwards Bypass", false));
     params.push_back (std::make_unique<juce::AudioParameterBool> ("VOCAL_MODE",   "Vocal Mode", false));
     params.push_back (std::make_unique<juce::AudioParameterBool> ("DRUMBUS_MODE", "Drumbus Mode", false));
+
+    // Sidechain (detector) EQ parameters
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("SC_HPF_FREQ",        "SC HPF Freq",        R (20.0f, 1000.0f, 0.1f, 0.4f), 20.0f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("SC_LOW_SHELF_FREQ",  "SC Low Shelf Freq",  R (40.0f, 1000.0f, 0.1f, 0.4f), 150.0f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("SC_LOW_SHELF_GAIN",  "SC Low Shelf Gain",  R (-12.0f, 12.0f, 0.01f), 0.0f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("SC_PEAK_FREQ",       "SC Peak Freq",       R (200.0f, 10000.0f, 0.1f, 0.3f), 1500.0f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("SC_PEAK_GAIN",       "SC Peak Gain",       R (-12.0f, 12.0f, 0.01f), 0.0f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("SC_PEAK_Q",          "SC Peak Q",          R (0.3f, 6.0f, 0.001f, 0.5f), 0.7071f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("SC_HIGH_SHELF_FREQ", "SC High Shelf Freq", R (1000.0f, 16000.0f, 1.0f, 0.4f), 6000.0f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("SC_HIGH_SHELF_GAIN", "SC High Shelf Gain", R (-12.0f, 12.0f, 0.01f), 0.0f));
     
     // Upwards compressor parameters
     params.push_back (std::make_unique<juce::AudioParameterFloat> ("UPWARDS_THRESHOLD",   "Upwards Threshold",  R (-60.0f, 0.0f, 0.01f), -40.0f));
@@ -542,6 +222,59 @@ juce::AudioProcessorValueTreeState::ParameterLayout CompressorPluginAudioProcess
     params.push_back (std::make_unique<juce::AudioParameterBool> ("UPWARDS_BYPASS",      "Upwards Bypass", false));
     params.push_back (std::make_unique<juce::AudioParameterBool> ("UPWARDS_FIRST",        "Upwards First", false));
 
+    // Evaluate gain curves and smoothing at control rate instead of per sample (lower CPU)
+    params.push_back (std::make_unique<juce::AudioParameterBool> ("CONTROL_RATE",         "Control Rate Gain", false));
+
+    // Final true-peak limiter (adds latency while on)
+    params.push_back (std::make_unique<juce::AudioParameterBool> ("TRUE_PEAK_LIMITER",    "True Peak Limiter", false));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("LIMITER_CEILING",     "Limiter Ceiling",    R (-12.0f, 0.0f, 0.01f), -1.0f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("LIMITER_RELEASE",     "Limiter Release",    R (10.0f, 1000.0f, 0.01f, 0.4f), 100.0f));
+
+    // Step down to cheaper engines while processing takes more than the budget
+    // (% of the block duration); the tier in use is reported read-only
+    params.push_back (std::make_unique<juce::AudioParameterBool> ("AUTO_QUALITY",         "Auto Quality", false));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("CPU_BUDGET",          "CPU Budget",         R (1.0f, 50.0f, 0.1f), 5.0f));
+    params.push_back (std::make_unique<QualityTierParameter>());
+
+    // Engine while the host bounces offline
+    params.push_back (std::make_unique<juce::AudioParameterChoice> ("RENDER_PROFILE",     "Render Profile",
+                                                                    juce::StringArray { "Same as Live", "Best Quality" }, 1));
+
+    // Detector link: instances in the same group (1..16) compress on the
+    // loudest member's level, or on the sum of all members'
+    params.push_back (std::make_unique<juce::AudioParameterInt> ("LINK_GROUP",            "Link Group", 0, 16, 0));
+    params.push_back (std::make_unique<juce::AudioParameterChoice> ("LINK_MODE",          "Link Mode",
+                                                                    juce::StringArray { "Loudest", "Sum" }, 0));
+
+    // Both stages per frequency bin (1024-point frames, adds 1024 samples latency)
+    params.push_back (std::make_unique<juce::AudioParameterBool> ("SPECTRAL_MODE",         "Spectral Mode", false));
+
+    // Split the per-channel work of wide buses (16+ channels) across worker
+    // threads; the output is the same as on one thread
+    params.push_back (std::make_unique<juce::AudioParameterChoice> ("CHANNEL_THREADS",    "Channel Threads",
+                                                                    juce::StringArray { "Off", "Offline Only", "Always" }, 0));
+
+    // Stage chain: the second stage in series or beside the first, and two
+    // more stages after them, each in series or beside the one before
+    params.push_back (std::make_unique<juce::AudioParameterBool> ("STAGE2_PARALLEL",      "Stage 2 Parallel", false));
+
+    for (int stage = 3; stage <= 4; ++stage)
+    {
+        const juce::String id = "STAGE" + juce::String (stage) + "_", name = "Stage " + juce::String (stage) + " ";
+        const float defaultThreshold = stage == 3 ? -12.0f : -6.0f;
+
+        params.push_back (std::make_unique<juce::AudioParameterChoice> (id + "TYPE",     name + "Type",
+                                                                        juce::StringArray { "Off", "Downwards", "Upwards", "Limiter" }, 0));
+        params.push_back (std::make_unique<juce::AudioParameterBool>  (id + "PARALLEL",  name + "Parallel", false));
+        params.push_back (std::make_unique<juce::AudioParameterFloat> (id + "THRESHOLD", name + "Threshold", R (-60.0f, 0.0f, 0.01f), defaultThreshold));
+        params.push_back (std::make_unique<juce::AudioParameterFloat> (id + "RATIO",     name + "Ratio",     R (1.0f, 20.0f, 0.01f), 4.0f));
+        params.push_back (std::make_unique<juce::AudioParameterFloat> (id + "ATTACK",    name + "Attack",    R (0.1f, 100.0f, 0.01f), 1.0f));
+        params.push_back (std::make_unique<juce::AudioParameterFloat> (id + "RELEASE",   name + "Release",   R (5.0f, 1000.0f, 0.01f), 50.0f));
+        params.push_back (std::make_unique<juce::AudioParameterFloat> (id + "KNEE",      name + "Knee",      R (0.0f, 24.0f, 0.01f), 0.0f));
+        params.push_back (std::make_unique<juce::AudioParameterFloat> (id + "MIX",       name + "Mix",       R (0.0f, 100.0f, 0.1f), 100.0f));
+        params.push_back (std::make_unique<juce::AudioParameterFloat> (id + "OUTPUT",    name + "Output",    R (-24.0f, 24.0f, 0.01f), 0.0f));
+    }
+
     return { params.begin(), params.end() };
 }
 
@@ -1,9 +1,13 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include <cmath>
+#include "Core/UltraDynCore.h"
+#include "SpectrumAnalyzer.h"
+#include "StaticArtCache.h"
 
-class CompressorPluginAudioProcessor : public juce::AudioProcessor
+class CompressorPluginAudioProcessor : public juce::AudioProcessor,
+                                       private juce::AudioProcessorValueTreeState::Listener,
+                                       private juce::Timer
 {
 public:
     //==============================================================================
@@ -43,105 +47,74 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
 
     // Public API for UI
-    float getGainReduction() const noexcept { return currentGRdB.load(); } // positive dB value (e.g., 6.2)
-    float getInputLevel() const noexcept { return inputLevel; }
-    float getOutputLevel() const noexcept { return outputLevel; }
-    float getUpwardsGain() const noexcept { return currentUpwardsGaindB.load(); } // positive dB value (e.g., 3.1)
-    bool isDownwardsBypassed() const noexcept { return apvts.getRawParameterValue("DOWNWARDS_BYPASS")->load() > 0.5f; }
-    bool isUpwardsBypassed() const noexcept { return apvts.getRawParameterValue("UPWARDS_BYPASS")->load() > 0.5f; }
+    float getGainReduction() const noexcept { return getMeters().gainReductionDb; } // positive dB value (e.g., 6.2)
+    float getInputLevel() const noexcept { return getMeters().inputLevelDb; }
+    float getOutputLevel() const noexcept { return getMeters().outputLevelDb; }
+    float getUpwardsGain() const noexcept { return getMeters().upwardsGainDb; } // positive dB value (e.g., 3.1)
+    bool isDownwardsBypassed() const noexcept { return downwardsBypassParam->load() > 0.5f; }
+    bool isUpwardsBypassed() const noexcept { return upwardsBypassParam->load() > 0.5f; }
 
     juce::AudioProcessorValueTreeState& getAPVTS() noexcept { return apvts; }
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
+    // Approximate memory owned by this instance, with shared tables split across their users
+    size_t getMemoryFootprintBytes() const noexcept;
+
+    // Of that, the core's scratch arena (every buffer the audio thread uses)
+    size_t getScratchBytes() const noexcept;
+
+    // Share of the time a stage's detector (0 downwards, 1 upwards) spent in
+    // each 1 dB level bin over about the last minute; false while nothing has
+    // been counted. Any thread.
+    using LevelDistribution = std::array<float, ULTRADYN_HISTOGRAM_BINS>;
+    bool getLevelDistribution (int stage, LevelDistribution& shares) const noexcept;
+
+    // Sets THRESHOLD so the downwards stage works on the loudest 30% of the
+    // material and UPWARDS_THRESHOLD for an average lift of 3 dB, from the
+    // level histograms. Message thread.
+    void applySuggestedThresholds();
+
+    // Detector and output spectra; runs only while an editor shows it
+    SpectrumAnalyzer& getSpectrumAnalyzer() noexcept { return analyzer; }
+
 private:
     //==============================================================================
-    // Simple RBJ peaking biquad for sidechain EQ (detector only)
-    struct Biquad
-    {
-        float b0{1.0f}, b1{0.0f}, b2{0.0f}, a1{0.0f}, a2{0.0f};
-        float z1{0.0f}, z2{0.0f};
-
-        void reset() noexcept { z1 = z2 = 0.0f; }
-
-        void setPeak (double sr, double freq, float Q, float gainDb) noexcept
-        {
-            const float A    = std::pow (10.0f, gainDb * 0.025f); // 10^(dB/40)
-            const float w0   = juce::MathConstants<float>::twoPi * (float) freq / (float) sr;
-            const float cw0  = std::cos (w0);
-            const float sw0  = std::sin (w0);
-            const float alpha = sw0 / (2.0f * juce::jmax (1.0e-6f, Q));
-
-            const float b0n = 1.0f + alpha * A;
-            const float b1n = -2.0f * cw0;
-            const float b2n = 1.0f - alpha * A;
-            const float a0n = 1.0f + alpha / A;
-            const float a1n = -2.0f * cw0;
-            const float a2n = 1.0f - alpha / A;
-
-            const float invA0 = 1.0f / a0n;
-            b0 = b0n * invA0;
-            b1 = b1n * invA0;
-            b2 = b2n * invA0;
-            a1 = a1n * invA0;
-            a2 = a2n * invA0;
-        }
-
-        inline float process (float x) noexcept
-        {
-            const float y = b0 * x + z1;
-            z1 = b1 * x - a1 * y + z2;
-            z2 = b2 * x - a2 * y;
-            return y;
-        }
-    };
-
-    // Vocal mode and drumbus mode for sidechain EQ
-    bool vocalModeEnabled = false;
-    bool drumbusModeEnabled = false;
-    
-    // Level tracking for meters
-    float inputLevel = -60.0f;
-    float outputLevel = -60.0f;
+    struct CoreDeleter { void operator() (ultradyn_compressor* c) const noexcept { ultradyn_destroy (c); } };
+
+    // All DSP lives in the JUCE-free core (Source/Core); this class only adapts
+    // it to the host: parameters are forwarded as they change, buffers in place
+    std::unique_ptr<ultradyn_compressor, CoreDeleter> core { ultradyn_create() };
+
+    // Reads the core's analyzer copies on its own thread; stopped before the core goes
+    SpectrumAnalyzer analyzer { *core };
 
     // Parameters
     juce::AudioProcessorValueTreeState apvts { *this, nullptr, "PARAMS", createParameterLayout() };
 
-    // Sidechain EQ for detector path (peak @ 1.5 kHz)
-    Biquad scEQ;
-
-    // Envelope follower (RMS) and gain computer state for downwards compressor
-    float env = 0.0f;        // RMS detector (squared average)
-    float smoothGain = 1.0f; // smoothed linear gain for attack/release
-
-    // Smoothers for attack/release (per-sample coefficients) for downwards compressor
-    float attackCoeff = 0.0f;
-    float releaseCoeff = 0.0f;
-
-    // GR meter for downwards compressor
-    std::atomic<float> currentGRdB { 0.0f }; // store as positive dB reduction
-
-    // Upwards compressor state
-    float upwardsEnv = 0.0f;        // RMS detector for upwards compressor
-    float upwardsSmoothGain = 1.0f; // smoothed linear gain for upwards compressor
-    float upwardsAttackCoeff = 0.0f;
-    float upwardsReleaseCoeff = 0.0f;
-    std::atomic<float> currentUpwardsGaindB { 0.0f }; // store as positive dB gain
-    bool upwardsInitialRamp = true; // Track if we're in initial ramp mode
-    int upwardsStartupDelay = 0; // Delay counter to prevent immediate processing
-    bool audioIsActive = false; // Track if audio is currently being processed
-    int audioInactiveCounter = 0; // Counter for detecting when audio stops
-    static const int ACTIVATION_DELAY_SAMPLES = 441; // 10ms at 44.1kHz
-    static const int DEACTIVATION_THRESHOLD = 2205; // 50ms of silence to deactivate
-
-    // Scratch buffers
-    juce::AudioBuffer<float> wetBuffer;
-    juce::AudioBuffer<float> scBuffer; // mono detector buffer
-
-    // Helpers
-    void updateSidechainEQ();
-    void updateTimeConstants();
-    float computeGain (float scSample) noexcept; // returns linear gain for downwards compressor
-    float computeUpwardsGain (float scSample) noexcept; // returns linear gain for upwards compressor
+    // Editor artwork, held here so it outlives any one editor
+    juce::SharedResourcePointer<StaticArtCache> editorArtCache;
+
+    // Raw parameter pointers the editor polls
+    std::atomic<float>* downwardsBypassParam = nullptr;
+    std::atomic<float>* upwardsBypassParam   = nullptr;
+
+    // Read-only tier parameter, set from timerCallback when the core's changes
+    juce::AudioParameterInt* qualityTierParam = nullptr;
+
+    // Set by parameterChanged (on any thread) when a switch needs the message
+    // thread: latency, link group or channel threads. Only a store, so the
+    // audio thread never posts a message.
+    std::atomic<bool> engineChangePending { false };
+
+    ultradyn_meters getMeters() const noexcept
+    {
+        ultradyn_meters m {};
+        ultradyn_get_meters (core.get(), &m);
+        return m;
+    }
+
+    void parameterChanged (const juce::String& parameterID, float newValue) override;
+    void timerCallback() override;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompressorPluginAudioProcessor)
-};
+};
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include "RealtimeSafety.h"
+
+#if ULTRADYN_RT_CHECKS && (defined (__linux__) || defined (__APPLE__))
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <poll.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RT_TLS __attribute__ ((tls_model ("initial-exec"))) thread_local
+
+namespace
+{
+    // Initial-exec TLS so touching these never allocates from inside malloc.
+    RT_TLS int audioThreadDepth = 0;
+    RT_TLS int allowDepth = 0;
+
+    std::atomic<int> violationCount { 0 };
+    bool abortOnViolation = false;
+
+    inline bool isChecking() noexcept { return audioThreadDepth > 0 && allowDepth == 0; }
+
+    void writeRaw (const char* text) noexcept;
+
+    void reportViolation (const char* what) noexcept
+    {
+        violationCount.fetch_add (1, std::memory_order_relaxed);
+
+        ++allowDepth; // the report itself writes and may allocate
+        writeRaw ("ultraDYN RT violation: ");
+        writeRaw (what);
+        writeRaw ("() called on the audio thread\n");
+
+        void* frames[48];
+        const int numFrames = backtrace (frames, 48);
+        if (numFrames > 1)
+            backtrace_symbols_fd (frames + 1, numFrames - 1, STDERR_FILENO);
+        writeRaw ("\n");
+        --allowDepth;
+
+        if (abortOnViolation)
+            std::abort();
+    }
+
+    inline void checkCall (const char* what) noexcept
+    {
+        if (isChecking())
+            reportViolation (what);
+    }
+
+    struct StartupInit
+    {
+        StartupInit()
+        {
+            // backtrace() lazily loads the unwinder on first use, which allocates
+            void* frames[2];
+            backtrace (frames, 2);
+
+            const char* env = std::getenv ("ULTRADYN_RT_ABORT");
+            abortOnViolation = env != nullptr && env[0] == '1';
+        }
+    };
+
+    StartupInit startupInit;
+}
+
+//==============================================================================
+namespace rtsafety
+{
+    ScopedAudioThread::ScopedAudioThread() noexcept  { ++audioThreadDepth; }
+    ScopedAudioThread::~ScopedAudioThread() noexcept { --audioThreadDepth; }
+
+    ScopedAllow::ScopedAllow() noexcept  { ++allowDepth; }
+    ScopedAllow::~ScopedAllow() noexcept { --allowDepth; }
+
+    bool isOnAudioThread() noexcept      { return audioThreadDepth > 0; }
+    int getViolationCount() noexcept     { return violationCount.load (std::memory_order_relaxed); }
+    void resetViolationCount() noexcept  { violationCount.store (0, std::memory_order_relaxed); }
+}
+
+//==============================================================================
+#if defined (__APPLE__)
+
+// dyld interposing: the replacement calls the original symbol directly, since
+// dyld never interposes calls made from inside the interposing image.
+#define RT_INTERPOSE(ret, name, params, args) \
+    static ret rt_##name params { checkCall (#name); return name args; } \
+    __attribute__ ((used)) static const struct { const void* replacement; const void* replacee; } rt_interpose_##name \
+        __attribute__ ((section ("__DATA,__interpose"))) = { (const void*) &rt_##name, (const void*) &name };
+
+#define RT_INTERPOSE_NOEXCEPT RT_INTERPOSE
+
+namespace
+{
+    void writeRaw (const char* text) noexcept { (void) ::write (STDERR_FILENO, text, std::strlen (text)); }
+}
+
+RT_INTERPOSE (void*, malloc,  (size_t size), (size))
+RT_INTERPOSE (void*, calloc,  (size_t count, size_t size), (count, size))
+RT_INTERPOSE (void*, realloc, (void* ptr, size_t size), (ptr, size))
+RT_INTERPOSE (void,  free,    (void* ptr), (ptr))
+RT_INTERPOSE (int,   posix_memalign, (void** out, size_t alignment, size_t size), (out, alignment, size))
+
+#else
+
+// ELF interposing: definitions in the executable win over libc, the originals
+// are looked up with RTLD_NEXT on first use.
+#define RT_INTERPOSE_IMPL(ret, name, params, args, spec) \
+    extern "C" ret name params spec \
+    { \
+        checkCall (#name); \
+        static auto real = reinterpret_cast<ret (*) params> (dlsym (RTLD_NEXT, #name)); \
+        return real args; \
+    }
+
+#define RT_INTERPOSE(ret, name, params, args)          RT_INTERPOSE_IMPL (ret, name, params, args, )
+#define RT_INTERPOSE_NOEXCEPT(ret, name, params, args) RT_INTERPOSE_IMPL (ret, name, params, args, noexcept)
+
+namespace
+{
+    using WriteFn = ssize_t (*) (int, const void*, size_t);
+
+    void writeRaw (const char* text) noexcept
+    {
+        static auto realWrite = reinterpret_cast<WriteFn> (dlsym (RTLD_NEXT, "write"));
+        (void) realWrite (STDERR_FILENO, text, std::strlen (text));
+    }
+
+    //==============================================================================
+    // dlsym() itself may calloc() before the real allocator has been resolved,
+    // so those early requests are served from a small static bump arena.
+    alignas (16) char bootstrapArena[4096];
+    size_t bootstrapUsed = 0;
+    RT_TLS bool resolvingAllocator = false;
+
+    bool isBootstrapPointer (const void* ptr) noexcept
+    {
+        auto* p = static_cast<const char*> (ptr);
+        return p >= bootstrapArena && p < bootstrapArena + sizeof (bootstrapArena);
+    }
+
+    void* bootstrapAlloc (size_t size) noexcept
+    {
+        const size_t aligned = (size + 15) & ~(size_t) 15;
+        if (bootstrapUsed + aligned > sizeof (bootstrapArena))
+            return nullptr;
+
+        void* p = bootstrapArena + bootstrapUsed;
+        bootstrapUsed += aligned;
+        return p;
+    }
+
+    template <typename Fn>
+    Fn resolveAllocator (const char* name) noexcept
+    {
+        resolvingAllocator = true;
+        auto fn = reinterpret_cast<Fn> (dlsym (RTLD_NEXT, name));
+        resolvingAllocator = false;
+        return fn;
+    }
+
+    using MallocFn        = void* (*) (size_t);
+    using CallocFn        = void* (*) (size_t, size_t);
+    using ReallocFn       = void* (*) (void*, size_t);
+    using FreeFn          = void  (*) (void*);
+    using PosixMemalignFn = int   (*) (void**, size_t, size_t);
+    using AlignedAllocFn  = void* (*) (size_t, size_t);
+}
+
+extern "C" void* malloc (size_t size) noexcept
+{
+    if (resolvingAllocator)
+        return bootstrapAlloc (size);
+
+    checkCall ("malloc");
+    static auto real = resolveAllocator<MallocFn> ("malloc");
+    return real (size);
+}
+
+extern "C" void* calloc (size_t count, size_t size) noexcept
+{
+    if (resolvingAllocator)
+    {
+        if (size != 0 && count > (size_t) -1 / size)
+            return nullptr;
+
+        return bootstrapAlloc (count * size); // static storage is already zeroed
+    }
+
+    checkCall ("calloc");
+    static auto real = resolveAllocator<CallocFn> ("calloc");
+    return real (count, size);
+}
+
+extern "C" void* realloc (void* ptr, size_t size) noexcept
+{
+    checkCall ("realloc");
+    static auto real = resolveAllocator<ReallocFn> ("realloc");
+
+    if (ptr != nullptr && isBootstrapPointer (ptr))
+    {
+        // Block sizes are not recorded; copy no further than the arena's end
+        const size_t available = (size_t) (bootstrapArena + sizeof (bootstrapArena) - static_cast<char*> (ptr));
+        void* moved = malloc (size);
+        if (moved != nullptr)
+            std::memcpy (moved, ptr, size < available ? size : available);
+        return moved;
+    }
+
+    return real (ptr, size);
+}
+
+extern "C" void free (void* ptr) noexcept
+{
+    if (ptr == nullptr || isBootstrapPointer (ptr))
+        return;
+
+    checkCall ("free");
+    static auto real = resolveAllocator<FreeFn> ("free");
+    real (ptr);
+}
+
+extern "C" int posix_memalign (void** out, size_t alignment, size_t size) noexcept
+{
+    checkCall ("posix_memalign");
+    static auto real = resolveAllocator<PosixMemalignFn> ("posix_memalign");
+    return real (out, alignment, size);
+}
+
+extern "C" void* aligned_alloc (size_t alignment, size_t size) noexcept
+{
+    checkCall ("aligned_alloc");
+    static auto real = resolveAllocator<AlignedAllocFn> ("aligned_alloc");
+    return real (alignment, size);
+}
+
+#endif
+
+//==============================================================================
+// Locks and blocking syscalls (cancellation points carry no exception spec)
+RT_INTERPOSE_NOEXCEPT (int, pthread_mutex_lock,    (pthread_mutex_t* m), (m))
+RT_INTERPOSE_NOEXCEPT (int, pthread_rwlock_rdlock, (pthread_rwlock_t* l), (l))
+RT_INTERPOSE_NOEXCEPT (int, pthread_rwlock_wrlock, (pthread_rwlock_t* l), (l))
+RT_INTERPOSE (int,     pthread_cond_wait, (pthread_cond_t* c, pthread_mutex_t* m), (c, m))
+RT_INTERPOSE (int,     pthread_join,      (pthread_t t, void** result), (t, result))
+RT_INTERPOSE (int,     sem_wait,          (sem_t* s), (s))
+RT_INTERPOSE (int,     nanosleep,         (const struct timespec* req, struct timespec* rem), (req, rem))
+RT_INTERPOSE (int,     usleep,            (useconds_t usec), (usec))
+RT_INTERPOSE (unsigned int, sleep,        (unsigned int seconds), (seconds))
+RT_INTERPOSE (ssize_t, read,              (int fd, void* buf, size_t count), (fd, buf, count))
+RT_INTERPOSE (ssize_t, write,             (int fd, const void* buf, size_t count), (fd, buf, count))
+RT_INTERPOSE (int,     poll,              (struct pollfd* fds, nfds_t count, int timeout), (fds, count, timeout))
+
+#endif
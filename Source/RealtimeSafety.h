@@ -0,0 +1,53 @@
+#pragma once
+
+//==============================================================================
+// Audio-thread real-time-safety checker (debug/test builds only).
+//
+// Build with ULTRADYN_RT_CHECKS=1 (e.g. `make CONFIG=Debug RT_CHECKS=1`) to
+// interpose malloc/free, mutex locking and blocking syscalls. While a
+// ScopedAudioThread is alive on the calling thread, any of those calls is
+// reported to stderr with a backtrace and counted.
+//
+// Interposition relies on the checker being linked into the executable itself
+// (Standalone build or a harness linking the sources). For a plugin loaded by a
+// host, LD_PRELOAD / DYLD_INSERT_LIBRARIES the plugin binary instead.
+//
+// Set ULTRADYN_RT_ABORT=1 in the environment to abort() on the first violation.
+// Without ULTRADYN_RT_CHECKS everything here compiles to nothing.
+//==============================================================================
+namespace rtsafety
+{
+#if ULTRADYN_RT_CHECKS
+    class ScopedAudioThread
+    {
+    public:
+        ScopedAudioThread() noexcept;
+        ~ScopedAudioThread() noexcept;
+
+        ScopedAudioThread (const ScopedAudioThread&) = delete;
+        ScopedAudioThread& operator= (const ScopedAudioThread&) = delete;
+    };
+
+    // Suspends checking on this thread, e.g. for deliberate one-off work.
+    class ScopedAllow
+    {
+    public:
+        ScopedAllow() noexcept;
+        ~ScopedAllow() noexcept;
+
+        ScopedAllow (const ScopedAllow&) = delete;
+        ScopedAllow& operator= (const ScopedAllow&) = delete;
+    };
+
+    bool isOnAudioThread() noexcept;
+    int getViolationCount() noexcept;
+    void resetViolationCount() noexcept;
+#else
+    struct ScopedAudioThread { ScopedAudioThread() noexcept {} };
+    struct ScopedAllow       { ScopedAllow() noexcept {} };
+
+    inline bool isOnAudioThread() noexcept { return false; }
+    inline int getViolationCount() noexcept { return 0; }
+    inline void resetViolationCount() noexcept {}
+#endif
+}
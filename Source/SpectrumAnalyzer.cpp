@@ -0,0 +1,188 @@
+#include "SpectrumAnalyzer.h"
+
+//==============================================================================
+SpectrumAnalyzer::SpectrumAnalyzer (ultradyn_compressor& c)
+    : juce::Thread ("ultraDYN analyzer"), core (c)
+{
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    stopThread (1000);
+}
+
+void SpectrumAnalyzer::addViewer()
+{
+    if (numViewers++ > 0)
+        return;
+
+    // First view of this instance: the buffers are kept from then on
+    if (fft.getSize() == 0)
+    {
+        fft.prepare (fftSize);
+
+        // Periodic Hann
+        window.resize ((size_t) fftSize);
+        for (int i = 0; i < fftSize; ++i)
+            window[(size_t) i] = 0.5f - 0.5f * std::cos (juce::MathConstants<float>::twoPi * (float) i / (float) fftSize);
+
+        detectorHistory.assign ((size_t) fftSize, 0.0f);
+        outputHistory.assign ((size_t) fftSize, 0.0f);
+        frame.assign ((size_t) fftSize, 0.0f);
+        re.assign ((size_t) numBins, 0.0f);
+        im.assign ((size_t) numBins, 0.0f);
+        for (auto& p : pulled)
+            p.assign ((size_t) fftSize, 0.0f);
+        detectorPower.assign ((size_t) numBins, 0.0f);
+        outputPower.assign ((size_t) numBins, 0.0f);
+    }
+
+    startThread();
+}
+
+void SpectrumAnalyzer::removeViewer()
+{
+    jassert (numViewers > 0);
+    if (--numViewers > 0)
+        return;
+
+    signalThreadShouldExit();
+    notify();
+    stopThread (1000);
+}
+
+void SpectrumAnalyzer::setDisplaySize (int width, int height) noexcept
+{
+    displayWidth.store (width, std::memory_order_relaxed);
+    displayHeight.store (height, std::memory_order_relaxed);
+}
+
+bool SpectrumAnalyzer::getPaths (juce::Path& detector, juce::Path& output)
+{
+    const juce::SpinLock::ScopedLockType lock (pathLock);
+    if (! pathsReady)
+        return false;
+
+    detector.swapWithPath (detectorReady);
+    output.swapWithPath (outputReady);
+    pathsReady = false;
+    return true;
+}
+
+//==============================================================================
+void SpectrumAnalyzer::run()
+{
+    ultradyn_set_analyzer_enabled (&core, 1);
+
+    // Start from silence rather than from where the last view left off
+    std::fill (detectorPower.begin(), detectorPower.end(), 0.0f);
+    std::fill (outputPower.begin(), outputPower.end(), 0.0f);
+
+    while (! threadShouldExit())
+    {
+        const auto started = juce::Time::getMillisecondCounter();
+
+        pullSamples();
+        analyse (detectorHistory, detectorPower);
+        analyse (outputHistory, outputPower);
+
+        const float width = (float) displayWidth.load (std::memory_order_relaxed);
+        const float height = (float) displayHeight.load (std::memory_order_relaxed);
+        if (width > 0.0f && height > 0.0f)
+        {
+            buildPath (detectorPower, detectorBuilt, width, height);
+            buildPath (outputPower, outputBuilt, width, height);
+
+            const juce::SpinLock::ScopedLockType lock (pathLock);
+            detectorReady.swapWithPath (detectorBuilt);
+            outputReady.swapWithPath (outputBuilt);
+            pathsReady = true;
+        }
+
+        const int elapsed = (int) (juce::Time::getMillisecondCounter() - started);
+        wait (juce::jmax (1, 1000 / framesPerSecond - elapsed));
+    }
+
+    ultradyn_set_analyzer_enabled (&core, 0);
+}
+
+// Everything the audio thread copied since the last frame, into the histories
+void SpectrumAnalyzer::pullSamples()
+{
+    for (;;)
+    {
+        const int n = ultradyn_read_analyzer (&core, pulled[0].data(), pulled[1].data(), fftSize);
+        if (n <= 0)
+            return;
+
+        for (int i = 0; i < n; ++i)
+        {
+            detectorHistory[(size_t) historyPosition] = pulled[0][(size_t) i];
+            outputHistory[(size_t) historyPosition] = pulled[1][(size_t) i];
+            historyPosition = (historyPosition + 1) & (fftSize - 1);
+        }
+    }
+}
+
+// Power per bin of the latest frame, scaled so a full-scale sine reads 0 dB
+// (the Hann window halves a sine's peak bin), rising at once and falling back
+// with a time constant of a few frames
+void SpectrumAnalyzer::analyse (const std::vector<float>& history, std::vector<float>& power)
+{
+    for (int i = 0; i < fftSize; ++i)
+        frame[(size_t) i] = history[(size_t) ((historyPosition + i) & (fftSize - 1))] * window[(size_t) i];
+
+    fft.forward (frame.data(), re.data(), im.data());
+
+    const float scale = 16.0f / ((float) fftSize * (float) fftSize);
+    for (int k = 0; k < numBins; ++k)
+    {
+        const float p = (re[(size_t) k] * re[(size_t) k] + im[(size_t) k] * im[(size_t) k]) * scale;
+        auto& average = power[(size_t) k];
+        average = p > average ? p : average + 0.25f * (p - average);
+    }
+}
+
+// Log frequency across, dB down. A point every two pixels; where a point spans
+// several bins it takes the loudest, below that it interpolates between bins.
+void SpectrumAnalyzer::buildPath (const std::vector<float>& power, juce::Path& path, float width, float height) const
+{
+    const float binsPerHz = (float) fftSize / (float) sampleRate.load (std::memory_order_relaxed);
+    const float octaves = std::log2 (maxFrequency / minFrequency);
+    const int numPoints = juce::jmax (2, (int) width / 2);
+
+    const auto binAt = [=] (int point)
+    {
+        const float bin = minFrequency * std::exp2 (octaves * (float) point / (float) numPoints) * binsPerHz;
+        return juce::jlimit (0.0f, (float) (numBins - 1), bin);
+    };
+
+    path.clear();
+    for (int i = 0; i <= numPoints; ++i)
+    {
+        const float from = binAt (i), to = binAt (i + 1);
+
+        float p;
+        if ((int) to > (int) from)
+        {
+            p = 0.0f;
+            for (int k = (int) from + 1; k <= (int) to; ++k)
+                p = juce::jmax (p, power[(size_t) k]);
+        }
+        else
+        {
+            const int k = juce::jmin ((int) from, numBins - 2);
+            const float t = from - (float) k;
+            p = power[(size_t) k] + t * (power[(size_t) k + 1] - power[(size_t) k]);
+        }
+
+        const float dB = 10.0f * std::log10 (p + 1.0e-12f);
+        const float x = width * (float) i / (float) numPoints;
+        const float y = juce::jlimit (0.0f, height, height * (maxDb - dB) / (maxDb - minDb));
+
+        if (i == 0)
+            path.startNewSubPath (x, y);
+        else
+            path.lineTo (x, y);
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Core/FFT.h"
+#include "Core/UltraDynCore.h"
+
+//==============================================================================
+// Detector (after the sidechain EQ) and output spectra for the editor. The
+// audio thread only copies into the core's analyzer ring; this thread pulls
+// from it, runs the FFTs, averages and builds the paths, at most 30 times a
+// second. It runs only while an editor shows it: with none open the thread is
+// stopped, the core copies nothing, and the buffers are never allocated.
+class SpectrumAnalyzer : private juce::Thread
+{
+public:
+    explicit SpectrumAnalyzer (ultradyn_compressor& core);
+    ~SpectrumAnalyzer() override;
+
+    // Display range of the paths
+    static constexpr float minFrequency = 20.0f, maxFrequency = 20000.0f;
+    static constexpr float minDb = -90.0f, maxDb = 0.0f;
+
+    // Any thread; from prepareToPlay
+    void setSampleRate (double newSampleRate) noexcept { sampleRate.store (newSampleRate, std::memory_order_relaxed); }
+
+    // Message thread: an editor starts or stops showing the spectra
+    void addViewer();
+    void removeViewer();
+
+    // Message thread: the paths are built for an area this size, origin at 0, 0
+    void setDisplaySize (int width, int height) noexcept;
+
+    // Message thread: swaps in the latest paths (left unchanged and false if
+    // none were built since the last call)
+    bool getPaths (juce::Path& detector, juce::Path& output);
+
+private:
+    static constexpr int fftSize = 2048;
+    static constexpr int numBins = fftSize / 2 + 1;
+    static constexpr int framesPerSecond = 30;
+
+    ultradyn_compressor& core;
+    std::atomic<double> sampleRate { 44100.0 };
+    std::atomic<int> displayWidth { 0 }, displayHeight { 0 };
+    int numViewers = 0;
+
+    // Analyzer thread: the last fftSize samples of each signal (circular),
+    // the Hann window, FFT scratch and the averaged power per bin
+    ultradyn::RealFFT fft;
+    std::vector<float> detectorHistory, outputHistory;
+    int historyPosition = 0;
+    std::vector<float> window, frame, re, im, pulled[2];
+    std::vector<float> detectorPower, outputPower;
+    juce::Path detectorBuilt, outputBuilt;
+
+    // Handed over to the message thread
+    juce::SpinLock pathLock;
+    juce::Path detectorReady, outputReady;
+    bool pathsReady = false;
+
+    void run() override;
+    void pullSamples();
+    void analyse (const std::vector<float>& history, std::vector<float>& power);
+    void buildPath (const std::vector<float>& power, juce::Path& path, float width, float height) const;
+
+    JUCE_DECLARE_NON_COPYABLE (SpectrumAnalyzer)
+};
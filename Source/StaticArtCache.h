@@ -0,0 +1,37 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <map>
+#include <tuple>
+
+//==============================================================================
+// Static editor artwork (panel backgrounds, meter scales) rendered once per
+// size and display scale. One cache is shared by every editor in the process
+// and kept alive by the processors, so reopening an editor or repainting a
+// meter only blits it. Message thread only.
+class StaticArtCache
+{
+public:
+    enum Artwork { editorBackground, inputOutputScale, gainReductionScale, upwardsGainScale, spectrumGrid };
+
+    template <typename PaintFn>
+    const juce::Image& get (Artwork art, int width, int height, float scale, PaintFn&& paintArt)
+    {
+        auto& image = images[std::make_tuple ((int) art, width, height, juce::roundToInt (scale * 100.0f))];
+
+        if (image.isNull())
+        {
+            image = juce::Image (juce::Image::ARGB, juce::jmax (1, juce::roundToInt ((float) width * scale)),
+                                 juce::jmax (1, juce::roundToInt ((float) height * scale)), true);
+            juce::Graphics g (image);
+            g.addTransform (juce::AffineTransform::scale (scale));
+            paintArt (g);
+        }
+
+        return image;
+    }
+
+private:
+    std::map<std::tuple<int, int, int, int>, juce::Image> images;
+};
@@ -0,0 +1,346 @@
+// ultraDYN benchmark: processing cost and memory per instance, multi-stream
+// engine throughput, RMS detector scan speed-up and editor open time.
+//
+//   ultraDYNBenchmark [--instances N] [--blocksize N] [--samplerate HZ] [--seconds S]
+//                     [--streams N] [--isa scalar|sse2|avx2|avx512|neon]
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "Core/BatchCompressor.h"
+#include "Core/DSPKernels.h"
+#include "Core/SharedTables.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+//==============================================================================
+// Counting global allocator, so memory per instance includes everything an
+// instance allocates (parameter tree, scratch buffers, shared table share).
+namespace
+{
+    std::atomic<long long> liveHeapBytes { 0 };
+
+    struct AllocHeader { void* raw; size_t size; };
+
+    void* countedAlloc (size_t size, size_t alignment)
+    {
+        alignment = juce::jmax (alignment, alignof (AllocHeader));
+        auto* raw = static_cast<char*> (std::malloc (size + alignment + sizeof (AllocHeader)));
+        if (raw == nullptr)
+            throw std::bad_alloc();
+
+        auto addr = reinterpret_cast<uintptr_t> (raw + sizeof (AllocHeader));
+        addr = (addr + alignment - 1) & ~(uintptr_t) (alignment - 1);
+
+        auto* header = reinterpret_cast<AllocHeader*> (addr) - 1;
+        header->raw = raw;
+        header->size = size;
+        liveHeapBytes += (long long) size;
+        return reinterpret_cast<void*> (addr);
+    }
+
+    void countedFree (void* ptr) noexcept
+    {
+        if (ptr == nullptr)
+            return;
+
+        auto* header = static_cast<AllocHeader*> (ptr) - 1;
+        liveHeapBytes -= (long long) header->size;
+        std::free (header->raw);
+    }
+}
+
+void* operator new (size_t size)                                 { return countedAlloc (size, alignof (std::max_align_t)); }
+void* operator new[] (size_t size)                               { return countedAlloc (size, alignof (std::max_align_t)); }
+void* operator new (size_t size, std::align_val_t al)            { return countedAlloc (size, (size_t) al); }
+void* operator new[] (size_t size, std::align_val_t al)          { return countedAlloc (size, (size_t) al); }
+void operator delete (void* p) noexcept                          { countedFree (p); }
+void operator delete[] (void* p) noexcept                        { countedFree (p); }
+void operator delete (void* p, size_t) noexcept                  { countedFree (p); }
+void operator delete[] (void* p, size_t) noexcept                { countedFree (p); }
+void operator delete (void* p, std::align_val_t) noexcept        { countedFree (p); }
+void operator delete[] (void* p, std::align_val_t) noexcept      { countedFree (p); }
+void operator delete (void* p, size_t, std::align_val_t) noexcept   { countedFree (p); }
+void operator delete[] (void* p, size_t, std::align_val_t) noexcept { countedFree (p); }
+
+//==============================================================================
+namespace
+{
+    struct BenchmarkConfig
+    {
+        int numInstances = 64;
+        int numStreams = 256;
+        int blockSize = 512;
+        double sampleRate = 48000.0;
+        double seconds = 10.0;
+        juce::String isa;
+    };
+
+    BenchmarkConfig parseArgs (const juce::ArgumentList& args)
+    {
+        BenchmarkConfig config;
+        if (args.containsOption ("--instances"))  config.numInstances = juce::jmax (1, args.getValueForOption ("--instances").getIntValue());
+        if (args.containsOption ("--blocksize"))  config.blockSize    = juce::jmax (1, args.getValueForOption ("--blocksize").getIntValue());
+        if (args.containsOption ("--samplerate")) config.sampleRate   = juce::jmax (8000.0, args.getValueForOption ("--samplerate").getDoubleValue());
+        if (args.containsOption ("--streams"))    config.numStreams   = juce::jmax (1, args.getValueForOption ("--streams").getIntValue());
+        if (args.containsOption ("--seconds"))    config.seconds      = juce::jmax (0.1, args.getValueForOption ("--seconds").getDoubleValue());
+        if (args.containsOption ("--isa"))        config.isa          = args.getValueForOption ("--isa");
+        return config;
+    }
+
+    void fillWithNoise (juce::AudioBuffer<float>& buffer, juce::Random& rng)
+    {
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            auto* data = buffer.getWritePointer (ch);
+            for (int n = 0; n < buffer.getNumSamples(); ++n)
+                data[n] = (rng.nextFloat() * 2.0f - 1.0f) * 0.25f;
+        }
+    }
+
+    std::unique_ptr<CompressorPluginAudioProcessor> createPrepared (const BenchmarkConfig& config)
+    {
+        auto proc = std::make_unique<CompressorPluginAudioProcessor>();
+        proc->setRateAndBufferSizeDetails (config.sampleRate, config.blockSize);
+        proc->prepareToPlay (config.sampleRate, config.blockSize);
+        return proc;
+    }
+
+    //==============================================================================
+    // Seconds of processing per second of audio, with the given parameter
+    // switched on (none: the defaults)
+    double measureThroughput (const BenchmarkConfig& config, const char* switchedOn)
+    {
+        auto proc = createPrepared (config);
+        if (switchedOn != nullptr)
+            proc->getAPVTS().getParameter (switchedOn)->setValueNotifyingHost (1.0f);
+
+        juce::AudioBuffer<float> source (2, config.blockSize), buffer (2, config.blockSize);
+        juce::MidiBuffer midi;
+        juce::Random rng (1234);
+        fillWithNoise (source, rng);
+
+        const int numBlocks = juce::jmax (1, (int) (config.seconds * config.sampleRate / config.blockSize));
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            buffer.makeCopyOf (source, true);
+            proc->processBlock (buffer, midi);
+        }
+        const double elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+
+        const double audioSeconds = (double) numBlocks * config.blockSize / config.sampleRate;
+        return elapsed / audioSeconds;
+    }
+
+    // A slow leveler into a fast peak catcher: as a three-stage chain in one
+    // instance, or the same stages stacked in two
+    double measureChain (const BenchmarkConfig& config, bool stacked)
+    {
+        const auto set = [] (CompressorPluginAudioProcessor& proc, const char* id, float value)
+        {
+            auto* p = proc.getAPVTS().getParameter (id);
+            p->setValueNotifyingHost (p->convertTo0to1 (value));
+        };
+
+        std::vector<std::unique_ptr<CompressorPluginAudioProcessor>> procs;
+        procs.push_back (createPrepared (config));
+        set (*procs[0], "ATTACK", 30.0f);
+        set (*procs[0], "RELEASE", 400.0f);
+        set (*procs[0], "RATIO", 2.0f);
+
+        if (stacked)
+        {
+            procs.push_back (createPrepared (config));
+            set (*procs[1], "THRESHOLD", -12.0f);
+            set (*procs[1], "RATIO", 20.0f);
+            set (*procs[1], "ATTACK", 1.0f);
+            set (*procs[1], "RELEASE", 50.0f);
+            set (*procs[1], "KNEE", 0.0f);
+            set (*procs[1], "UPWARDS_BYPASS", 1.0f);
+        }
+        else
+        {
+            set (*procs[0], "STAGE3_TYPE", 3.0f);
+        }
+
+        juce::AudioBuffer<float> source (2, config.blockSize), buffer (2, config.blockSize);
+        juce::MidiBuffer midi;
+        juce::Random rng (1234);
+        fillWithNoise (source, rng);
+
+        const int numBlocks = juce::jmax (1, (int) (config.seconds * config.sampleRate / config.blockSize));
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            buffer.makeCopyOf (source, true);
+            for (auto& proc : procs)
+                proc->processBlock (buffer, midi);
+        }
+        const double elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+
+        const double audioSeconds = (double) numBlocks * config.blockSize / config.sampleRate;
+        return elapsed / audioSeconds;
+    }
+
+    void runThroughput (const BenchmarkConfig& config)
+    {
+        const double nsPerSecond = 1.0e9 / config.sampleRate;
+
+        const double load = measureThroughput (config, nullptr);
+        std::printf ("Processing:           %.2f ns/sample, %.1fx realtime (%.3f%% of one core per instance)\n",
+                     load * nsPerSecond, 1.0 / load, 100.0 * load);
+
+        const double spectralLoad = measureThroughput (config, "SPECTRAL_MODE");
+        std::printf ("Spectral mode:        %.2f ns/sample, %.1fx realtime (%.2fx broadband)\n",
+                     spectralLoad * nsPerSecond, 1.0 / spectralLoad, spectralLoad / load);
+
+        const double chainLoad = measureChain (config, false);
+        const double stackedLoad = measureChain (config, true);
+        std::printf ("Three-stage chain:    %.2f ns/sample, %.2fx the same stages in two stacked instances\n",
+                     chainLoad * nsPerSecond, chainLoad / stackedLoad);
+    }
+
+    // Mono streams with their own settings through one BatchCompressor
+    void runBatch (const BenchmarkConfig& config)
+    {
+        ultradyn::BatchCompressor batch;
+        batch.prepare (config.sampleRate, config.numStreams);
+
+        juce::AudioBuffer<float> source (config.numStreams, config.blockSize), buffer (config.numStreams, config.blockSize);
+        juce::Random rng (1234);
+        fillWithNoise (source, rng);
+
+        // Spread the settings so lanes take different branches of the curves
+        for (int s = 0; s < config.numStreams; ++s)
+        {
+            batch.setParameter (s, ULTRADYN_PARAM_THRESHOLD, -10.0f - (float) (s % 40));
+            batch.setParameter (s, ULTRADYN_PARAM_RATIO, 2.0f + (float) (s % 7));
+            batch.setParameter (s, ULTRADYN_PARAM_SC_HPF_FREQ, 20.0f + (float) (s % 5) * 40.0f);
+        }
+
+        const int numBlocks = juce::jmax (1, (int) (config.seconds * config.sampleRate / config.blockSize));
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            buffer.makeCopyOf (source, true);
+            batch.process (buffer.getArrayOfWritePointers(), config.blockSize);
+        }
+        const double elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+
+        // The copy is charged too, as a server would pay for it
+        const double audioSeconds = (double) numBlocks * config.blockSize / config.sampleRate;
+        std::printf ("Batch engine:         %d streams, %d per instruction, %.2f ns/sample/stream, %.0f streams per core in realtime\n",
+                     config.numStreams, batch.getLaneWidth(),
+                     elapsed * 1.0e9 / ((double) numBlocks * config.blockSize * config.numStreams),
+                     audioSeconds * config.numStreams / elapsed);
+    }
+
+    // The RMS detector's recurrence, serial (scalar kernels) against the
+    // selected kernels' prefix scan, over runs of several lengths. The core
+    // detects in sub-blocks of 128; the longer runs show where the scan goes.
+    void runDetector (const BenchmarkConfig& config)
+    {
+        const auto& serial = *ultradyn::kernels::getScalarTable();
+        const auto& scan = ultradyn::kernels::select();
+
+        const int total = 1 << 16;
+        std::vector<float> input ((size_t) total), env ((size_t) total);
+        juce::Random rng (1234);
+        for (auto& x : input)
+            x = (rng.nextFloat() * 2.0f - 1.0f) * 0.25f;
+
+        const int numPasses = juce::jmax (1, (int) (config.seconds * config.sampleRate / total));
+
+        const auto nsPerSample = [&] (const ultradyn::kernels::Table& table, int length)
+        {
+            float state = 0.0f;
+            const auto start = juce::Time::getHighResolutionTicks();
+            for (int pass = 0; pass < numPasses; ++pass)
+                for (int i = 0; i + length <= total; i += length)
+                    table.rmsEnvelope (input.data() + i, env.data() + i, length, 0.99f, state);
+            const double elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+            return elapsed * 1.0e9 / ((double) numPasses * (double) (total / length * length));
+        };
+
+        for (const int length : { 32, 128, 1024, 8192 })
+        {
+            const double serialNs = nsPerSample (serial, length);
+            const double scanNs = nsPerSample (scan, length);
+            std::printf ("RMS detector, %4d:   %.2f ns/sample serial, %.2f ns/sample %s scan (%.1fx)\n",
+                         length, serialNs, scanNs, scan.name, serialNs / scanNs);
+        }
+    }
+
+    // Construction plus the first full paint, as a host opening the window
+    // sees it. The first open also renders the shared background artwork.
+    void runEditorOpen (const BenchmarkConfig& config)
+    {
+        auto proc = createPrepared (config);
+
+        const int numOpens = 20;
+        double firstMs = 0.0, laterMs = 0.0;
+
+        for (int i = 0; i < numOpens; ++i)
+        {
+            const auto start = juce::Time::getHighResolutionTicks();
+            {
+                std::unique_ptr<juce::AudioProcessorEditor> editor (proc->createEditor());
+                editor->createComponentSnapshot (editor->getLocalBounds());
+            }
+            const double ms = 1000.0 * juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+
+            if (i == 0) firstMs = ms;
+            else        laterMs += ms / (numOpens - 1);
+        }
+
+        std::printf ("Editor open:          %.2f ms first, %.2f ms after (construct + first paint, incl. close)\n", firstMs, laterMs);
+    }
+
+    void runMemory (const BenchmarkConfig& config)
+    {
+        std::vector<std::unique_ptr<CompressorPluginAudioProcessor>> instances;
+        instances.reserve ((size_t) config.numInstances);
+
+        // Warm up process-wide singletons and shared tables so they are not charged to the instances
+        auto warmup = createPrepared (config);
+
+        const long long before = liveHeapBytes.load();
+        for (int i = 0; i < config.numInstances; ++i)
+            instances.push_back (createPrepared (config));
+        const long long after = liveHeapBytes.load();
+
+        const double perInstanceKb = (double) (after - before) / config.numInstances / 1024.0;
+        std::printf ("Memory per instance:  %.1f KB heap (%d instances), %.1f KB own state estimate\n",
+                     perInstanceKb, config.numInstances,
+                     (double) instances.front()->getMemoryFootprintBytes() / 1024.0);
+        std::printf ("Scratch arena:        %.1f KB per instance, one 64-byte aligned block\n",
+                     (double) instances.front()->getScratchBytes() / 1024.0);
+        std::printf ("Shared table sets:    %d live\n", ultradyn::SharedTables::getNumLiveTableSets());
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    const auto config = parseArgs (juce::ArgumentList (argc, argv));
+
+    if (config.isa.isNotEmpty())
+        ultradyn::kernels::setOverride (ultradyn::kernels::parseISA (config.isa.toRawUTF8()));
+
+    std::printf ("ultraDYN benchmark: %.0f Hz, block %d, %.1f s of audio, %s kernels\n\n",
+                 config.sampleRate, config.blockSize, config.seconds, ultradyn::kernels::select().name);
+
+    runThroughput (config);
+    runBatch (config);
+    runDetector (config);
+    runEditorOpen (config);
+    runMemory (config);
+    return 0;
+}
@@ -0,0 +1,229 @@
+// ultraDYN real-time-safety driver: runs the core under the audio-thread
+// checker (Source/RealtimeSafety.h) and fails on any violation.
+//
+//   ultraDYNRTCheck [--blocks N] [--seed N]
+//
+// For several sample rates and channel counts the same instance is prepared
+// again, then processes N blocks of random length, from 1 sample to four times
+// the prepared block size, of noise with silent stretches. Before a quarter
+// of the blocks a few random parameters change on the audio thread, the
+// engine switches (SPECTRAL_MODE, TRUE_PEAK_LIMITER, STAGE3/4_TYPE,
+// CHANNEL_THREADS, ...) more often than the rest. What the plugin does off
+// the audio thread (joining link groups, starting channel threads, reading
+// the analyzer) happens here between blocks. Exits 1 if anything on the audio
+// thread allocated, locked or blocked.
+//
+// First it checks the detector's level curve is continuous down to its
+// -100 dB floor: quiet signals would otherwise get the wrong lift without
+// anything on the audio thread going wrong.
+
+#include "Core/BatchKernel.h"
+#include "Core/CompressorStage.h"
+#include "Core/UltraDynCore.h"
+#include "RealtimeSafety.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#if ! ULTRADYN_RT_CHECKS
+ #error "build with ULTRADYN_RT_CHECKS=1 (make rtcheck)"
+#endif
+
+namespace
+{
+    struct PrepareConfig
+    {
+        double sampleRate;
+        int numChannels;
+        int blockSize;
+    };
+
+    // Wide enough for channel threads in one of them
+    const PrepareConfig configs[] =
+    {
+        { 44100.0,  2,  512 },
+        { 48000.0, 24,  256 },
+        { 96000.0,  1, 1024 },
+        { 22050.0, 16,   64 },
+        { 48000.0,  2,  128 },
+    };
+
+    // Switching these changes what the engine runs, so they are drawn more often
+    const int engineParams[] =
+    {
+        ULTRADYN_PARAM_SPECTRAL_MODE, ULTRADYN_PARAM_TRUE_PEAK_LIMITER, ULTRADYN_PARAM_STAGE3_TYPE,
+        ULTRADYN_PARAM_STAGE4_TYPE, ULTRADYN_PARAM_CHANNEL_THREADS, ULTRADYN_PARAM_CONTROL_RATE,
+        ULTRADYN_PARAM_AUTO_QUALITY, ULTRADYN_PARAM_UPWARDS_FIRST, ULTRADYN_PARAM_LINK_GROUP,
+    };
+
+    struct Options
+    {
+        int numBlocks = 4000;
+        unsigned seed = 1;
+    };
+
+    Options parseArgs (int argc, char* argv[])
+    {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            if (std::strcmp (argv[i], "--blocks") == 0)    options.numBlocks = std::max (1, std::atoi (argv[i + 1]));
+            else if (std::strcmp (argv[i], "--seed") == 0) options.seed = (unsigned) std::strtoul (argv[i + 1], nullptr, 10);
+        }
+        return options;
+    }
+
+    // The RMS level of mean squares from 1e-12 to 1 against 10 * log10, which
+    // the -100 dB floor may only raise, in the core's stages and the batch
+    // engine's (the SIMD levels run the same polynomial)
+    bool checkDetectorLevels()
+    {
+        using BatchMath = ultradyn::batch::Math<ultradyn::batch::ScalarVec>;
+
+        float worst = 0.0f, worstMeanSquare = 0.0f;
+        for (double dB = -120.0; dB <= 0.0; dB += 0.125)
+        {
+            const float meanSquare = (float) std::pow (10.0, dB / 10.0);
+            const float expected = (float) std::max (-100.0, dB);
+            const float error = std::max (std::abs (ultradyn::meanSquareToDb (meanSquare) - expected),
+                                          std::abs (BatchMath::meanSquareToDb (meanSquare) - expected));
+            if (error > worst)
+            {
+                worst = error;
+                worstMeanSquare = meanSquare;
+            }
+        }
+
+        // The ends of the range the upwards stages work in
+        const float at1e9 = ultradyn::meanSquareToDb (1.0e-9f), at1e8 = ultradyn::meanSquareToDb (1.0e-8f);
+        const bool ok = worst < 0.01f && std::abs (at1e9 + 90.0f) < 0.01f && std::abs (at1e8 + 80.0f) < 0.01f;
+
+        if (! ok)
+            std::printf ("ultraDYNRTCheck: detector level off by %.3f dB at mean square %g (1e-9: %.2f dB, 1e-8: %.2f dB)\n",
+                         worst, worstMeanSquare, at1e9, at1e8);
+        return ok;
+    }
+
+    // A value within the parameter's range; whole numbers for the switches
+    float randomValue (int param, std::mt19937& rng)
+    {
+        float minValue = 0.0f, maxValue = 0.0f;
+        ultradyn_param_range (param, &minValue, &maxValue);
+        const float value = std::uniform_real_distribution<float> (minValue, maxValue) (rng);
+
+        const bool discrete = param == ULTRADYN_PARAM_LINK_GROUP
+                              || (maxValue - minValue <= 3.0f && std::floor (minValue) == minValue && std::floor (maxValue) == maxValue);
+        return discrete ? std::round (value) : value;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    const auto options = parseArgs (argc, argv);
+    if (! checkDetectorLevels())
+        return 1;
+
+    std::mt19937 rng (options.seed);
+
+    std::unique_ptr<ultradyn_compressor, decltype (&ultradyn_destroy)> core (ultradyn_create(), &ultradyn_destroy);
+    if (core == nullptr)
+        return 1;
+
+    ultradyn_compressor* c = core.get();
+    std::vector<float> analyzerDetector (16384), analyzerOutput (16384);
+    long long totalSamples = 0;
+
+    for (const auto& config : configs)
+    {
+        // Off the audio thread: a fresh set of parameters, prepare and the
+        // updates that allocate
+        for (int p = 0; p < ULTRADYN_NUM_PARAMS; ++p)
+            ultradyn_set_param (c, p, randomValue (p, rng));
+
+        if (ultradyn_prepare (c, config.sampleRate, config.numChannels) != 0)
+            return 1;
+
+        ultradyn_update_link (c);
+        ultradyn_update_channel_threads (c);
+        ultradyn_set_analyzer_enabled (c, (int) (rng() & 1));
+
+        const int maxBlock = config.blockSize * 4;
+        std::vector<std::vector<float>> buffers ((size_t) config.numChannels, std::vector<float> ((size_t) maxBlock));
+        std::vector<float*> channels ((size_t) config.numChannels);
+        for (int ch = 0; ch < config.numChannels; ++ch)
+            channels[(size_t) ch] = buffers[(size_t) ch].data();
+
+        std::normal_distribution<float> noise (0.0f, 0.3f);
+        std::uniform_int_distribution<int> blockSizes (1, maxBlock);
+        std::uniform_int_distribution<int> anyParam (0, ULTRADYN_NUM_PARAMS - 1);
+        std::uniform_int_distribution<int> anyEngineParam (0, (int) (sizeof (engineParams) / sizeof (engineParams[0])) - 1);
+
+        for (int block = 0; block < options.numBlocks; ++block)
+        {
+            const int numSamples = blockSizes (rng);
+
+            // Loud, quiet and silent stretches, so the upwards stages start and stop
+            const float level = (block / 50) % 3 == 2 ? 0.0f : ((block / 50) % 3 == 1 ? 0.01f : 1.0f);
+            for (auto& buffer : buffers)
+                for (int i = 0; i < numSamples; ++i)
+                    buffer[(size_t) i] = noise (rng) * level;
+
+            // Drawn here: the audio thread only stores them
+            int changed[4] = { -1, -1, -1, -1 };
+            float values[4] = {};
+            if (rng() % 4 == 0)
+            {
+                for (int k = 0; k < 4; ++k)
+                {
+                    changed[k] = rng() % 2 == 0 ? engineParams[anyEngineParam (rng)] : anyParam (rng);
+                    values[k] = randomValue (changed[k], rng);
+                }
+            }
+
+            ultradyn_set_non_realtime (c, rng() % 8 == 0);
+
+            {
+                rtsafety::ScopedAudioThread audioThread;
+
+                for (int k = 0; k < 4; ++k)
+                    if (changed[k] >= 0)
+                        ultradyn_set_param (c, changed[k], values[k]);
+
+                ultradyn_process (c, channels.data(), config.numChannels, numSamples);
+
+                ultradyn_meters meters;
+                ultradyn_get_meters (c, &meters);
+                (void) ultradyn_quality_tier (c);
+            }
+
+            // What the plugin hands to the message thread after such changes
+            for (int k = 0; k < 4; ++k)
+            {
+                if (changed[k] == ULTRADYN_PARAM_LINK_GROUP)
+                    ultradyn_update_link (c);
+                else if (changed[k] == ULTRADYN_PARAM_CHANNEL_THREADS)
+                    ultradyn_update_channel_threads (c);
+            }
+
+            (void) ultradyn_latency_samples (c);
+            while (ultradyn_read_analyzer (c, analyzerDetector.data(), analyzerOutput.data(), (int) analyzerOutput.size()) > 0) {}
+
+            totalSamples += numSamples;
+        }
+
+        ultradyn_reset (c);
+    }
+
+    const int violations = rtsafety::getViolationCount();
+    std::printf ("ultraDYNRTCheck: %d configurations, %lld samples, %d violation%s\n",
+                 (int) (sizeof (configs) / sizeof (configs[0])), totalSamples, violations, violations == 1 ? "" : "s");
+
+    return violations > 0 ? 1 : 0;
+}